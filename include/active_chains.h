@@ -0,0 +1,115 @@
+// Copyright (c) 2020, the BACCA contributors, as
+// shown by the AUTHORS file. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef BACCA_ACTIVE_CHAINS_H_
+#define BACCA_ACTIVE_CHAINS_H_
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Containers of the chains left open by the raster scan, in the order in which the scan line
+// crosses them. Each entry is the index of the RCCode elem owning the chain. Max points insert
+// a pair of entries and min points remove one, always a few positions away from the current
+// scan position. Algorithms working on RCCode take the container as template parameter.
+
+// Plain std::vector: every insertion or removal moves all the chains that follow it.
+class ChainsVector {
+    std::vector<unsigned> data_;
+
+public:
+    ChainsVector() {}
+    ChainsVector(std::vector<unsigned> values) : data_(std::move(values)) {}
+
+    unsigned& operator[](unsigned pos) { return data_[pos]; }
+    const unsigned& operator[](unsigned pos) const { return data_[pos]; }
+
+    size_t size() const { return data_.size(); }
+
+    // Inserts two entries with the given value before pos
+    void InsertPair(unsigned pos, unsigned value) {
+        data_.insert(data_.begin() + pos, 2, value);
+    }
+
+    // Removes the entries at pos and pos + 1
+    void ErasePair(unsigned pos) {
+        data_.erase(data_.begin() + pos, data_.begin() + pos + 2);
+    }
+
+    std::vector<unsigned> Values() const { return data_; }
+};
+
+// Gap buffer: the free space is kept where the last insertion or removal took place, so the
+// following ones, which come further along the same scan line, only move the chains in between.
+// The cost of a row is then linear in the open chains, no matter how many min and max points it
+// has: the gap is moved back from where the previous row left it, then forward along the row.
+class ChainsGapBuffer {
+    std::vector<unsigned> data_;
+    unsigned gap_begin_ = 0;
+    unsigned gap_end_ = 0;
+
+    void MoveGap(unsigned pos) {
+        unsigned* data = data_.data();
+        if (pos < gap_begin_) {
+            const unsigned n = gap_begin_ - pos;
+            std::memmove(data + gap_end_ - n, data + pos, n * sizeof(unsigned));
+            gap_begin_ -= n;
+            gap_end_ -= n;
+        }
+        else if (pos > gap_begin_) {
+            const unsigned n = pos - gap_begin_;
+            std::memmove(data + gap_begin_, data + gap_end_, n * sizeof(unsigned));
+            gap_begin_ += n;
+            gap_end_ += n;
+        }
+    }
+
+    // Doubles the capacity, all the new space is added to the gap
+    void Grow() {
+        const unsigned capacity = static_cast<unsigned>(data_.size());
+        const unsigned new_capacity = std::max(32u, capacity * 2);
+        const unsigned tail = capacity - gap_end_;
+        data_.resize(new_capacity);
+        unsigned* data = data_.data();
+        std::memmove(data + new_capacity - tail, data + gap_end_, tail * sizeof(unsigned));
+        gap_end_ = new_capacity - tail;
+    }
+
+public:
+    ChainsGapBuffer() {}
+    ChainsGapBuffer(std::vector<unsigned> values) : data_(std::move(values)) {
+        gap_begin_ = gap_end_ = static_cast<unsigned>(data_.size());
+    }
+
+    unsigned& operator[](unsigned pos) { return data_[pos < gap_begin_ ? pos : pos + (gap_end_ - gap_begin_)]; }
+    const unsigned& operator[](unsigned pos) const { return data_[pos < gap_begin_ ? pos : pos + (gap_end_ - gap_begin_)]; }
+
+    size_t size() const { return data_.size() - (gap_end_ - gap_begin_); }
+
+    // Inserts two entries with the given value before pos
+    void InsertPair(unsigned pos, unsigned value) {
+        if (gap_end_ - gap_begin_ < 2) {
+            Grow();
+        }
+        MoveGap(pos);
+        data_[gap_begin_++] = value;
+        data_[gap_begin_++] = value;
+    }
+
+    // Removes the entries at pos and pos + 1
+    void ErasePair(unsigned pos) {
+        MoveGap(pos);
+        gap_end_ += 2;
+    }
+
+    std::vector<unsigned> Values() const {
+        std::vector<unsigned> values(data_.begin(), data_.begin() + gap_begin_);
+        values.insert(values.end(), data_.begin() + gap_end_, data_.end());
+        return values;
+    }
+};
+
+#endif // !BACCA_ACTIVE_CHAINS_H_
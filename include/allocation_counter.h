@@ -0,0 +1,17 @@
+// Copyright (c) 2020, the BACCA contributors, as
+// shown by the AUTHORS file. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef BACCA_ALLOCATION_COUNTER_H_
+#define BACCA_ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+// Number of heap allocations performed by the program so far, from any thread. The global
+// operator new is replaced in allocation_counter.cc in order to keep the count, only when
+// BACCA_COUNT_ALLOCATIONS is defined: otherwise the count is always 0.
+uint64_t AllocationsNumber();
+
+#endif // !BACCA_ALLOCATION_COUNTER_H_
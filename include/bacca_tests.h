@@ -47,6 +47,10 @@ public:
     void AverageTestWithSteps();
     void DensityTest();
     void MemoryTest();
+    void ScalabilityTest();
+    void ThroughputTest();
+    void OpenChainsTest();
+    void AllocationsTest();
     void LatexGenerator();
     void GranularityTest();
 
@@ -96,7 +100,8 @@ private:
                 filesystem::path filename_path = dataset_path / filesystem::path(filename);
 
                 // Load image
-                if (!GetBinaryImage(filename_path, ChainCodeAlg::img_)) {
+                cv::Mat1b img;
+                if (!GetBinaryImage(filename_path, img)) {
                     ob.Cmessage("Unable to open '" + filename + "'");
                     continue;
                 }
@@ -108,19 +113,21 @@ private:
 
 
                     ChainCodeAlg *ref = ChainCodeAlgMapSingleton::GetChainCodeAlg(check_algo_name);
+                    ref->img_ = img;
                     ref->PerformChainCode();
-                    ChainCode chain_code_correct = ref->chain_code_;
-                    std::vector<cv::Vec4i> hierarchy_correct = ref->hierarchy_;
+                    ChainCode chain_code_correct = ref->TakeChainCode();
+                    std::vector<cv::Vec4i> hierarchy_correct = std::move(ref->hierarchy_);
                     ref->FreeChainCodeData();
 
                     ChainCodeAlg *algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(algo_name);
+                    algorithm->img_ = img;
 
                     // Perform labeling on current algorithm if it has no previously failed
                     if (stats[j]) {
                         (algorithm->*func)(std::forward<Args>(args)...);
 
-                        ChainCode chain_code_to_check = algorithm->chain_code_;
-                        std::vector<cv::Vec4i> hierarchy_to_check = algorithm->hierarchy_;
+                        ChainCode chain_code_to_check = algorithm->TakeChainCode();
+                        std::vector<cv::Vec4i> hierarchy_to_check = std::move(algorithm->hierarchy_);
                         
                         bool diff = false;
                         if (algorithm->with_hierarchy_) {
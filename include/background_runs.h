@@ -0,0 +1,115 @@
+// Copyright (c) 2020, the BACCA contributors, as
+// shown by the AUTHORS file. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef BACCA_BACKGROUND_RUNS_H_
+#define BACCA_BACKGROUND_RUNS_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#define BACCA_USE_AVX2
+#define BACCA_USE_SSE2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BACCA_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Skipping of the background runs in the raster scan of the Spaghetti algorithms. Rows are given
+// as pointers to their first pixel, and a column is background when all of them are zero there.
+
+inline unsigned CountTrailingZeros(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+inline uint8_t OrPixels(int c, const uint8_t* row) {
+    return row[c];
+}
+
+template <typename... Rows>
+inline uint8_t OrPixels(int c, const uint8_t* row, Rows... rows) {
+    return row[c] | OrPixels(c, rows...);
+}
+
+#ifdef BACCA_USE_SSE2
+inline __m128i OrPixels16(int c, const uint8_t* row) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + c));
+}
+
+template <typename... Rows>
+inline __m128i OrPixels16(int c, const uint8_t* row, Rows... rows) {
+    return _mm_or_si128(OrPixels16(c, row), OrPixels16(c, rows...));
+}
+#endif
+
+#ifdef BACCA_USE_AVX2
+inline __m256i OrPixels32(int c, const uint8_t* row) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + c));
+}
+
+template <typename... Rows>
+inline __m256i OrPixels32(int c, const uint8_t* row, Rows... rows) {
+    return _mm256_or_si256(OrPixels32(c, row), OrPixels32(c, rows...));
+}
+#endif
+
+// Returns the first column, from c on, which is not background, or w if there is none
+template <typename... Rows>
+inline int NextForegroundColumn(int c, int w, Rows... rows) {
+
+#ifdef BACCA_USE_AVX2
+    for (; c + 32 <= w; c += 32) {
+        const __m256i zero = _mm256_cmpeq_epi8(OrPixels32(c, rows...), _mm256_setzero_si256());
+        const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(zero));
+        if (mask != 0xFFFFFFFFu) {
+            return c + CountTrailingZeros(~mask);
+        }
+    }
+#endif
+
+#ifdef BACCA_USE_SSE2
+    for (; c + 16 <= w; c += 16) {
+        const __m128i zero = _mm_cmpeq_epi8(OrPixels16(c, rows...), _mm_setzero_si128());
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(zero));
+        if (mask != 0xFFFFu) {
+            return c + CountTrailingZeros(~mask);
+        }
+    }
+#endif
+
+    for (; c < w; ++c) {
+        if (OrPixels(c, rows...)) {
+            return c;
+        }
+    }
+    return w;
+}
+
+// Column from which a decision forest can go on after the action of a background pixel in
+// column c, which does nothing. The tree it jumps to can only know the pixels of the window
+// in columns c and c + 1, so if the window is background from column c to column c + k + 1,
+// the same tree can be entered from column c + k, and the k pixels in between are skipped:
+// their whole window is background and their action does nothing as well.
+template <typename... Rows>
+inline int SkipBackground(int c, int w, Rows... rows) {
+    if (c + 2 >= w || OrPixels(c + 2, rows...) || OrPixels(c + 1, rows...) || OrPixels(c, rows...)) {
+        return c;
+    }
+    return NextForegroundColumn(c + 3, w, rows...) - 2;
+}
+
+#endif // !BACCA_BACKGROUND_RUNS_H_
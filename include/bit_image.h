@@ -0,0 +1,107 @@
+// Copyright (c) 2020, the BACCA contributors, as
+// shown by the AUTHORS file. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef BACCA_BIT_IMAGE_H_
+#define BACCA_BIT_IMAGE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "background_runs.h"
+
+inline unsigned CountTrailingZeros64(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return index;
+#elif defined(_MSC_VER)
+    const uint32_t low = static_cast<uint32_t>(mask);
+    return low ? CountTrailingZeros(low) : 32 + CountTrailingZeros(static_cast<uint32_t>(mask >> 32));
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// Binary image with 1 bit per pixel: pixel (r, c) is bit c % 64 of word c / 64 of row r. Every
+// row is followed by at least one background word, and the image is framed by a background row
+// above and one below, so that the neighborhood of any pixel can be read without checks. The
+// words are kept from one image to the next.
+class BitImage {
+
+    std::vector<uint64_t> words_;
+
+public:
+    int rows = 0;
+    int cols = 0;
+    int words_per_row = 0;
+
+    // Packs img, whose non-zero pixels are foreground
+    void Pack(const cv::Mat1b& img) {
+        rows = img.rows;
+        cols = img.cols;
+        words_per_row = cols / 64 + 1;
+        words_.assign(static_cast<size_t>(rows + 2) * words_per_row, 0);
+
+        for (int r = 0; r < rows; r++) {
+            const uint8_t* const img_row = img.ptr<uint8_t>(r);
+            uint64_t* const row = words_.data() + static_cast<size_t>(r + 1) * words_per_row;
+            int c = 0;
+#ifdef BACCA_USE_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            for (; c + 16 <= cols; c += 16) {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(img_row + c));
+                const uint64_t bits = ~static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(pixels, zero))) & 0xFFFFu;
+                row[c >> 6] |= bits << (c & 63);
+            }
+#endif
+            for (; c < cols; c++) {
+                row[c >> 6] |= static_cast<uint64_t>(img_row[c] != 0) << (c & 63);
+            }
+        }
+    }
+
+    // Row r, with r from -1 to rows
+    const uint64_t* Row(int r) const {
+        return words_.data() + static_cast<size_t>(r + 1) * words_per_row;
+    }
+
+    // Pixel in column c of row, with c from 0 to cols
+    static unsigned Pixel(const uint64_t* row, int c) {
+        return static_cast<unsigned>(row[c >> 6] >> (c & 63)) & 1u;
+    }
+
+    static uint64_t OrWords(int k, const uint64_t* row) {
+        return row[k];
+    }
+
+    template <typename... Rows>
+    static uint64_t OrWords(int k, const uint64_t* row, Rows... rows) {
+        return row[k] | OrWords(k, rows...);
+    }
+
+    // Returns the first column, from c on, in which any of the rows has a foreground pixel,
+    // 64 columns at a time, or cols if there is none
+    template <typename... Rows>
+    int NextForegroundColumn(int c, Rows... rows) const {
+        if (c >= cols) {
+            return cols;
+        }
+        int k = c >> 6;
+        uint64_t word = OrWords(k, rows...) & (~uint64_t(0) << (c & 63));
+        while (word == 0) {
+            if (++k == words_per_row) {
+                return cols;
+            }
+            word = OrWords(k, rows...);
+        }
+        const int next = (k << 6) + static_cast<int>(CountTrailingZeros64(word));
+        return next < cols ? next : cols;
+    }
+};
+
+#endif // !BACCA_BIT_IMAGE_H_
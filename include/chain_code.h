@@ -14,138 +14,343 @@
 #ifndef BACCA_CHAIN_CODE_H_
 #define BACCA_CHAIN_CODE_H_
 
+#include <functional>
 #include <vector>
 #include <set>
 #include <memory>
 #include <algorithm>
+#include <limits>
 #include <numeric>
+#include <type_traits>
 
 #include <opencv2/imgproc.hpp>
 
-#define PREALLOC_ELEMS 5000
-//#define PREALLOC_INTS 3
-
+// Node of the tree of contours, stored in an RCNodeTree and addressed by its index there
 struct RCNode {
 
     enum class Status { O, H, potO, potH, none };
 
+    static constexpr unsigned kNone = ~0u;
+
     int elem_index;
-    RCNode* parent = nullptr;
-    std::vector<std::unique_ptr<RCNode>> children;
+    unsigned parent;                    // as given on creation, see RCNodeTree::Parent()
+    unsigned first_child = kNone;
+    unsigned last_child = kNone;
+    unsigned prev_sibling = kNone;
+    unsigned next_sibling = kNone;
+    unsigned same;                      // node this one was merged into, itself if it was not
+    unsigned region;                    // node whose region this one's became when merged, itself if it was not
     Status status = Status::none;
 
-    RCNode(int elem_index_) : elem_index(elem_index_) {}
-    RCNode(int elem_index_, RCNode* parent_) : elem_index(elem_index_), parent(parent_) {}
-    RCNode(int elem_index_, RCNode* parent_, Status status_) :
-        elem_index(elem_index_), parent(parent_), status(status_) {}
+    RCNode(unsigned id, int elem_index_, unsigned parent_, Status status_) :
+        elem_index(elem_index_), parent(parent_), same(id), region(id), status(status_) {}
+};
+
+// Tree of contours built by the algorithms which also retrieve the hierarchy. Nodes live in a
+// single vector, the root being the background, and every max point stores the index of its node.
+// When two partial contours turn out to be the same one, the merged node is not removed: it is
+// linked to the node that replaces it, both as a contour, see Find(), and as the region containing
+// its children, see Parent(). Max points and children thus keep their indices and are resolved
+// lazily with path halving, and merging only splices the lists of children, in constant time.
+class RCNodeTree {
+
+    std::vector<RCNode> nodes_;
 
-    RCNode* EmplaceChild(int elem_index_, Status status_) {
-        children.push_back(std::move(std::make_unique<RCNode>(elem_index_, this, status_)));
-        return children.back().get();
+    void Unlink(unsigned owner, unsigned node) {
+        RCNode& n = nodes_[node];
+        if (n.prev_sibling == RCNode::kNone) {
+            nodes_[owner].first_child = n.next_sibling;
+        }
+        else {
+            nodes_[n.prev_sibling].next_sibling = n.next_sibling;
+        }
+        if (n.next_sibling == RCNode::kNone) {
+            nodes_[owner].last_child = n.prev_sibling;
+        }
+        else {
+            nodes_[n.next_sibling].prev_sibling = n.prev_sibling;
+        }
     }
 
-    void DeleteChild(RCNode* child) {
-        auto is_child = [child](std::unique_ptr<RCNode>& n) {return n.get() == child; };
+public:
+    static constexpr unsigned kRoot = 0;
 
-        auto child_it = std::find_if(std::begin(children), std::end(children), is_child);
-        assert(child_it != std::end(children));
+    // Leaves the root alone, keeping the memory of the other nodes. Must be called before use.
+    void Reset() {
+        nodes_.clear();
+        nodes_.emplace_back(kRoot, -1, kRoot, RCNode::Status::none);
+    }
 
-        children.erase(child_it);
+    void Swap(RCNodeTree& other) {
+        nodes_.swap(other.nodes_);
     }
-};
 
-struct RCCode {
+    RCNode& operator[](unsigned node) { return nodes_[node]; }
+    const RCNode& operator[](unsigned node) const { return nodes_[node]; }
 
-    struct Chain {
-    private:
-        std::vector<uint32_t> internal_values;
-        //unsigned elem; // index of the corresponding elem in vector
-    public:
-        unsigned int value_count = 0;
+    size_t Size() const { return nodes_.size(); }
 
-        Chain() {
-            //internal_values.resize(PREALLOC_INTS);
+    // Adds a node as last child of the region parent and returns its index
+    unsigned EmplaceChild(unsigned parent, int elem_index, RCNode::Status status) {
+        const unsigned node = static_cast<unsigned>(nodes_.size());
+        nodes_.emplace_back(node, elem_index, parent, status);
+        const unsigned owner = FindRegion(parent);
+        RCNode& o = nodes_[owner];
+        if (o.last_child == RCNode::kNone) {
+            o.first_child = node;
         }
-        // Chain(unsigned elem_) : elem(elem_) {}
-        inline void push_back(uint8_t val) {
-            if ((value_count & 15) == 0 /*&& value_count / 16 >= PREALLOC_INTS*/) { // x & 15 is a "clever" way of doing x % 16
-                internal_values.push_back(0);
-            }
+        else {
+            nodes_[o.last_child].next_sibling = node;
+            nodes_[node].prev_sibling = o.last_child;
+        }
+        o.last_child = node;
+        return node;
+    }
 
-            internal_values[value_count / 16] |= ((val & 3) << ((value_count & 15) * 2));
-            value_count++;
+    // Node which currently stands for the contour of node
+    unsigned Find(unsigned node) {
+        while (nodes_[node].same != node) {
+            nodes_[node].same = nodes_[nodes_[node].same].same;
+            node = nodes_[node].same;
         }
+        return node;
+    }
 
-        // TODO try to optimize removal and successive addition
-        inline uint8_t pop_back() {
-            value_count--;
-            const unsigned int index = value_count / 16;
-            uint8_t res = (internal_values[index] >> ((value_count & 15) * 2)) & 3;
-            // zero the two bits of the popped value
-            internal_values[index] &= ~(3 << ((value_count & 15) * 2));
-            return res;
+    // Node which currently stands for the region of node, as parent of other nodes
+    unsigned FindRegion(unsigned node) {
+        while (nodes_[node].region != node) {
+            nodes_[node].region = nodes_[nodes_[node].region].region;
+            node = nodes_[node].region;
         }
+        return node;
+    }
+
+    unsigned Parent(unsigned node) { return FindRegion(nodes_[node].parent); }
 
-        inline const uint8_t get_value(unsigned index) const {
-            return (internal_values[index / 16] >> ((index % 16) * 2)) & 3;
+    // Merges the node src into dst when two chains of their partial contours are connected. The
+    // children of src are moved under dst, or under the parent of dst when the two nodes had
+    // different status (a potential hole turned out to be part of an outer contour, or vice versa).
+    void Merge(unsigned dst, unsigned src, bool different_status = false) {
+        const unsigned new_parent = different_status ? Parent(dst) : dst;
+        Unlink(Parent(src), src);
+
+        RCNode& s = nodes_[src];
+        if (s.first_child != RCNode::kNone) {
+            RCNode& p = nodes_[new_parent];
+            if (p.last_child == RCNode::kNone) {
+                p.first_child = s.first_child;
+            }
+            else {
+                nodes_[p.last_child].next_sibling = s.first_child;
+                nodes_[s.first_child].prev_sibling = p.last_child;
+            }
+            p.last_child = s.last_child;
+            s.first_child = s.last_child = RCNode::kNone;
         }
-        //auto begin() { return vals.begin(); }
-        //auto begin() const { return vals.begin(); }
-        //auto end() { return vals.end(); }
-        //auto end() const { return vals.end(); }
+        s.same = dst;
+        s.region = new_parent;
+
+        // Nodes point to the top-left max point of their contour
+        nodes_[dst].elem_index = std::min(nodes_[dst].elem_index, s.elem_index);
+    }
+};
+
+// Bump allocator for the words of RCCode chains. Memory is taken from large slabs which are
+// kept when the arena is reset, so that the same slabs serve one image after the other and
+// chains never call malloc on their own. Blocks given back with Release() are recycled by
+// the following allocations of the same size class.
+class ChainArena {
+
+    struct Slab {
+        std::unique_ptr<uint32_t[]> words;
+        size_t size;
     };
 
-    struct MaxPoint  {        
+    std::vector<Slab> slabs_;
+    size_t next_slab_ = 0;
+    uint32_t* cursor_ = nullptr;
+    uint32_t* end_ = nullptr;
+    std::vector<std::vector<uint32_t*>> free_blocks_;   // released blocks of 2^i words in free_blocks_[i]
 
-        unsigned row, col;
-        Chain left;
-        Chain right;
-        unsigned next;  // vector index of the elem whose left chain is linked to this elem right chain
-        unsigned prev;  // vector index of the elem whose right chain is linked to this elem left chain
-                        // prev field is only necessary when hierarchy is needed,
-                        // it is not known if prev field is bad for performance when it is not used
-        RCNode* node = nullptr; // it is not known if this added field is bad for performance when it is not used
+    static unsigned SizeClass(size_t n_words) {
+        unsigned size_class = 0;
+        while ((size_t(1) << size_class) < n_words) {
+            size_class++;
+        }
+        return size_class;
+    }
 
-        // MaxPoint() {}
-        MaxPoint(unsigned r_, unsigned c_, unsigned elem_, RCNode* node_) : 
-            row(r_), col(c_), left(), right(), next(elem_), prev(elem_), node(node_) {}
-        MaxPoint(unsigned r_, unsigned c_, unsigned elem_) : MaxPoint(r_, c_, elem_, nullptr) {}
+    void NextSlab(size_t n_words) {
+        while (next_slab_ < slabs_.size() && slabs_[next_slab_].size < n_words) {
+            next_slab_++;
+        }
+        if (next_slab_ == slabs_.size()) {
+            const size_t size = std::max(kSlabWords, n_words);
+            slabs_.push_back({ std::unique_ptr<uint32_t[]>(new uint32_t[size]), size });
+        }
+        cursor_ = slabs_[next_slab_].words.get();
+        end_ = cursor_ + slabs_[next_slab_].size;
+        next_slab_++;
+    }
 
-    };
+public:
+    static constexpr size_t kSlabWords = 1 << 16;
 
-    void AddElem(unsigned r_, unsigned c_) {
-        data.emplace_back(r_, c_, static_cast<unsigned int>(data.size()));
-        value_count++;
+    // Returns n_words uninitialized words, valid until the next Reset()
+    uint32_t* Allocate(size_t n_words) {
+        if (!free_blocks_.empty()) {
+            const unsigned size_class = SizeClass(n_words);
+            if (size_class < free_blocks_.size() && !free_blocks_[size_class].empty()) {
+                uint32_t* words = free_blocks_[size_class].back();
+                free_blocks_[size_class].pop_back();
+                return words;
+            }
+        }
+        if (static_cast<size_t>(end_ - cursor_) < n_words) {
+            NextSlab(n_words);
+        }
+        uint32_t* words = cursor_;
+        cursor_ += n_words;
+        return words;
     }
-    void AddElem(unsigned r_, unsigned c_, RCNode* node_) {
-        data.emplace_back(r_, c_, static_cast<unsigned int>(data.size()), node_);
-        value_count++;
+
+    // Makes a block of n_words words, a power of two, available to the following allocations
+    void Release(uint32_t* words, size_t n_words) {
+        const unsigned size_class = SizeClass(n_words);
+        if (size_class >= free_blocks_.size()) {
+            free_blocks_.resize(size_class + 1);
+        }
+        free_blocks_[size_class].push_back(words);
     }
 
+    // Makes all the memory available again, without releasing it
+    void Reset() {
+        next_slab_ = 0;
+        cursor_ = end_ = nullptr;
+        for (auto& blocks : free_blocks_) {
+            blocks.clear();
+        }
+    }
 
-    size_t Size() const { 
-        return value_count;
+    // Same as Reset(), but the slabs past the first max_words words are released
+    void Trim(size_t max_words) {
+        Reset();
+        size_t words = 0;
+        size_t kept = 0;
+        for (; kept < slabs_.size() && words + slabs_[kept].size <= max_words; kept++) {
+            words += slabs_[kept].size;
+        }
+        slabs_.resize(kept);
     }
 
-    MaxPoint& operator[](unsigned pos) { return data[pos]; }
-    const MaxPoint& operator[](unsigned pos) const { return data[pos]; }
+    size_t SlabsNumber() const { return slabs_.size(); }
+};
 
-    void Clean() {
-        data = std::vector<MaxPoint>();
-        root = nullptr;
+// Links of a chain, 2 bits each. The first 16 links are stored inside the chain itself,
+// longer chains move to words allocated from a ChainArena.
+struct RCChain {
+private:
+    uint32_t* words_ = nullptr;     // nullptr while links fit in inline_word_
+    ChainArena* arena_ = nullptr;
+    uint32_t inline_word_ = 0;
+    unsigned capacity_ = 1;         // number of words available
+
+    uint32_t* words() { return words_ ? words_ : &inline_word_; }
+    const uint32_t* words() const { return words_ ? words_ : &inline_word_; }
+
+    void Reserve(unsigned n_words) {
+        if (n_words <= capacity_) {
+            return;
+        }
+        unsigned new_capacity = capacity_ * 2;
+        while (new_capacity < n_words) {
+            new_capacity *= 2;
+        }
+        uint32_t* new_words = arena_->Allocate(new_capacity);
+        std::copy_n(words(), capacity_, new_words);
+        std::fill(new_words + capacity_, new_words + new_capacity, 0);
+        if (words_) {
+            arena_->Release(words_, capacity_);
+        }
+        words_ = new_words;
+        capacity_ = new_capacity;
     }
 
-    RCCode(bool retrieve_topology = false) {
-        if (retrieve_topology) {
-            root = std::make_unique<RCNode>(-1);
+public:
+    unsigned int value_count = 0;
+
+    RCChain(ChainArena* arena = nullptr) : arena_(arena) {}
+
+    inline void push_back(uint8_t val) {
+        const unsigned int index = value_count / 16;
+        if (index == capacity_) {
+            Reserve(capacity_ + 1);
         }
+
+        words()[index] |= ((val & 3) << ((value_count & 15) * 2));
+        value_count++;
     }
 
-    int value_count = 0;
-    std::vector<MaxPoint> data;
-    std::unique_ptr<RCNode> root;
+    // TODO try to optimize removal and successive addition
+    inline uint8_t pop_back() {
+        value_count--;
+        const unsigned int index = value_count / 16;
+        uint32_t& word = words()[index];
+        uint8_t res = (word >> ((value_count & 15) * 2)) & 3;
+        // zero the two bits of the popped value
+        word &= ~(3 << ((value_count & 15) * 2));
+        return res;
+    }
+
+    inline const uint8_t get_value(unsigned index) const {
+        return (words()[index / 16] >> ((index % 16) * 2)) & 3;
+    }
+
+    // Packed values, 16 per word starting from the least significant bits
+    const uint32_t* data() const { return words(); }
+
+    // Appends all the values of other at the end of this chain, a whole word at a time
+    void append(const RCChain& other) {
+        const unsigned n_other_words = (other.value_count + 15) / 16;
+        Reserve((value_count + other.value_count + 15) / 16);
+
+        uint32_t* dst = words() + value_count / 16;
+        const uint32_t* src = other.words();
+        const unsigned shift = (value_count & 15) * 2;
+        if (shift == 0) {
+            std::copy_n(src, n_other_words, dst);
+        }
+        else {
+            for (unsigned i = 0; i < n_other_words; i++) {
+                dst[i] |= src[i] << shift;
+                // The last shifted word may fall beyond the capacity, when it holds no values
+                if (dst + i + 1 < words() + capacity_) {
+                    dst[i + 1] = src[i] >> (32 - shift);
+                }
+            }
+        }
+
+        value_count += other.value_count;
+    }
+
+    // Gives the words back to the arena and empties the chain
+    void Release() {
+        if (words_) {
+            arena_->Release(words_, capacity_);
+            words_ = nullptr;
+        }
+        inline_word_ = 0;
+        capacity_ = 1;
+        value_count = 0;
+    }
+    //auto begin() { return vals.begin(); }
+    //auto begin() const { return vals.begin(); }
+    //auto end() { return vals.end(); }
+    //auto end() const { return vals.end(); }
 };
 
+template <typename Topology>
+struct BasicRCCode;
 
 struct ChainCode {
 
@@ -159,8 +364,8 @@ struct ChainCode {
 
         bool operator==(const Chain& rhs) const;
         bool operator<(const Chain& rhs) const;
-        void AddRightChain(const RCCode::Chain& chain);
-        void AddLeftChain(const RCCode::Chain& chain);
+        void AddRightChain(const RCChain& chain);
+        void AddLeftChain(const RCChain& chain);
         //const uint8_t& operator[](size_t pos) const { return vals[pos]; }
         //std::vector<uint8_t>::const_iterator begin() const { return vals.begin(); }
         //std::vector<uint8_t>::const_iterator end() const { return vals.end(); }
@@ -190,7 +395,8 @@ struct ChainCode {
     const Chain& operator[](size_t pos) const { return chains[pos]; }
     std::vector<Chain>::const_iterator begin() const { return chains.begin(); }
     std::vector<Chain>::const_iterator end() const { return chains.end(); }
-    void AddChain(const RCCode& rccode, std::vector<int>& used_elems, unsigned pos);
+    template <typename Topology>
+    void AddChain(const BasicRCCode<Topology>& rccode, std::vector<int>& used_elems, unsigned pos);
     bool operator==(const ChainCode& rhs) const {
         return chains == rhs.chains;
     }
@@ -206,12 +412,691 @@ struct ChainCode {
 
 };
 
+// Contours of an image in two flat arrays instead of a vector per contour, so that they take a
+// couple of allocations, kept from one image to the next, and are read from contiguous memory.
+// The value_count values of each contour, 8 per word as in ChainCode::Chain, start at word
+// first_word of values: every contour starts on a new word.
+struct FlatChainCode {
+
+    struct Contour {
+        unsigned row, col;
+        size_t first_word;
+        size_t value_count;
+    };
+
+    std::vector<uint32_t> values;
+    std::vector<Contour> contours;
+
+    size_t Size() const { return contours.size(); }
+
+    const uint32_t* Words(size_t i) const { return values.data() + contours[i].first_word; }
+
+    uint8_t GetValue(size_t i, size_t index) const {
+        return (Words(i)[index / 8] >> ((index & 7) * 4)) & 15;
+    }
+
+    // Empties the container, keeping its memory
+    void Clear() {
+        values.clear();
+        contours.clear();
+    }
+
+    // Replaces the content with the contours found by cv::findContours, as the ChainCode constructor does
+    void Assign(const std::vector<std::vector<cv::Point>>& cv_contours, bool contrary = false);
+
+    // Replaces the content with the chains of chcode
+    void Assign(const ChainCode& chcode);
+
+    // Copy with a vector per contour, for code expecting a ChainCode
+    ChainCode ToChainCode() const;
+};
+
+// Receives every contour as soon as the raster scan closes it, see ChainCodeAlg::SetContourSink()
+using ContourSink = std::function<void(ChainCode::Chain&&)>;
+
+// Contours kept by the algorithms which retrieve the hierarchy, see ChainCodeAlg::SetContourRetrieval().
+// External matches RETR_EXTERNAL of OpenCV; Holes keeps the inner contours alone, with no hierarchy
+// among them, as the second level of RETR_CCOMP.
+enum class ContourRetrieval { All, External, Holes };
+
+// Topology policies of the raster scan chain code. The node in the tree of contours is only
+// needed to retrieve the hierarchy, so elems have that field only when WithTopology is used.
+struct NoTopology {
+    static constexpr bool kEnabled = false;
+};
+
+struct WithTopology {
+    static constexpr bool kEnabled = true;
+};
+
+class RCCodeWorkspace;
+
+template <typename Topology>
+struct BasicRCCode {
+
+    using Chain = RCChain;
+
+#ifndef BACCA_RCCODE_SOA
+
+    struct MaxPointBase {
+        unsigned row, col;
+        Chain left;
+        Chain right;
+        unsigned next;  // vector index of the elem whose left chain is linked to this elem right chain
+
+        MaxPointBase(unsigned r_, unsigned c_, unsigned elem_, ChainArena* arena_) :
+            row(r_), col(c_), left(arena_), right(arena_), next(elem_) {}
+    };
+
+    struct MaxPointTopology : MaxPointBase {
+        unsigned node;  // index in tree, possibly of a node merged since, see Node()
+
+        MaxPointTopology(unsigned r_, unsigned c_, unsigned elem_, ChainArena* arena_, unsigned node_ = RCNode::kNone) :
+            MaxPointBase(r_, c_, elem_, arena_), node(node_) {}
+    };
+
+    using MaxPoint = std::conditional_t<Topology::kEnabled, MaxPointTopology, MaxPointBase>;
+
+    using ElemRef = MaxPoint&;
+    using ConstElemRef = const MaxPoint&;
+
+    // Adds a max point and returns its index
+    unsigned AddElem(unsigned r_, unsigned c_) {
+        unsigned elem;
+        if (free_elems_.empty()) {
+            elem = static_cast<unsigned int>(data.size());
+            data.emplace_back(r_, c_, elem, arena_);
+            value_count++;
+        }
+        else {
+            elem = free_elems_.back();
+            free_elems_.pop_back();
+            data[elem] = MaxPoint(r_, c_, elem, arena_);
+        }
+        if (sink_) {
+            TrackElem(elem);
+        }
+        return elem;
+    }
+    unsigned AddElem(unsigned r_, unsigned c_, unsigned node_) {
+        static_assert(Topology::kEnabled, "Nodes are only stored when topology is retrieved");
+        data.emplace_back(r_, c_, static_cast<unsigned int>(data.size()), arena_, node_);
+        value_count++;
+        return static_cast<unsigned int>(data.size()) - 1;
+    }
+
+    // Appends a copy of the elem in position pos of src, links are not translated
+    void AppendElem(const BasicRCCode& src, unsigned pos) {
+        data.push_back(src.data[pos]);
+        value_count++;
+    }
+
+    void Reserve(size_t n) { data.reserve(n); }
+
+    size_t Size() const { 
+        return value_count;
+    }
+
+    MaxPoint& operator[](unsigned pos) { return data[pos]; }
+    const MaxPoint& operator[](unsigned pos) const { return data[pos]; }
+
+    unsigned Row(unsigned pos) const { return data[pos].row; }
+    unsigned Col(unsigned pos) const { return data[pos].col; }
+    unsigned Next(unsigned pos) const { return data[pos].next; }
+    const Chain& Left(unsigned pos) const { return data[pos].left; }
+    const Chain& Right(unsigned pos) const { return data[pos].right; }
+
+    void Clean() {
+        data = std::vector<MaxPoint>();
+        tree = RCNodeTree();
+    }
+
+private:
+    void ClearElems() {
+        data.clear();
+        value_count = 0;
+    }
+
+    void SwapElems(BasicRCCode& other) {
+        data.swap(other.data);
+    }
+
+    size_t ElemsCapacity() const {
+        return data.capacity();
+    }
+
+public:
+
+#else // BACCA_RCCODE_SOA
+
+    // Every field of the elems has its own array, so that walking the links or extending the
+    // chains only touches the data involved. Elems are accessed through these proxies, which
+    // expose the same fields of MaxPoint.
+    struct ConstElemRefBase {
+        const unsigned& row;
+        const unsigned& col;
+        const Chain& left;
+        const Chain& right;
+        const unsigned& next;
+
+        ConstElemRefBase(const BasicRCCode& rccode, unsigned pos) :
+            row(rccode.rows[pos]), col(rccode.cols[pos]), left(rccode.left_chains[pos]),
+            right(rccode.right_chains[pos]), next(rccode.next_links[pos]) {}
+    };
+
+    struct ConstElemRefTopology : ConstElemRefBase {
+        const unsigned& node;
+
+        ConstElemRefTopology(const BasicRCCode& rccode, unsigned pos) :
+            ConstElemRefBase(rccode, pos), node(rccode.nodes[pos]) {}
+    };
+
+    using ConstElemRef = std::conditional_t<Topology::kEnabled, ConstElemRefTopology, ConstElemRefBase>;
+
+    struct ElemRefBase {
+        const BasicRCCode& rccode_;
+        const unsigned pos_;
+
+        unsigned& row;
+        unsigned& col;
+        Chain& left;
+        Chain& right;
+        unsigned& next;
+
+        ElemRefBase(BasicRCCode& rccode, unsigned pos) : rccode_(rccode), pos_(pos),
+            row(rccode.rows[pos]), col(rccode.cols[pos]), left(rccode.left_chains[pos]),
+            right(rccode.right_chains[pos]), next(rccode.next_links[pos]) {}
+
+        operator ConstElemRef() const { return ConstElemRef(rccode_, pos_); }
+    };
+
+    struct ElemRefTopology : ElemRefBase {
+        unsigned& node;
+
+        ElemRefTopology(BasicRCCode& rccode, unsigned pos) :
+            ElemRefBase(rccode, pos), node(rccode.nodes[pos]) {}
+    };
+
+    using ElemRef = std::conditional_t<Topology::kEnabled, ElemRefTopology, ElemRefBase>;
+
+    // Adds a max point and returns its index
+    unsigned AddElem(unsigned r_, unsigned c_) {
+        unsigned elem;
+        if (free_elems_.empty()) {
+            elem = static_cast<unsigned>(rows.size());
+            rows.push_back(r_);
+            cols.push_back(c_);
+            left_chains.emplace_back(arena_);
+            right_chains.emplace_back(arena_);
+            next_links.push_back(elem);
+            if (Topology::kEnabled) {
+                nodes.push_back(RCNode::kNone);
+            }
+            value_count++;
+        }
+        else {
+            elem = free_elems_.back();
+            free_elems_.pop_back();
+            rows[elem] = r_;
+            cols[elem] = c_;
+            left_chains[elem] = Chain(arena_);
+            right_chains[elem] = Chain(arena_);
+            next_links[elem] = elem;
+        }
+        if (sink_) {
+            TrackElem(elem);
+        }
+        return elem;
+    }
+    unsigned AddElem(unsigned r_, unsigned c_, unsigned node_) {
+        static_assert(Topology::kEnabled, "Nodes are only stored when topology is retrieved");
+        const unsigned elem = AddElem(r_, c_);
+        nodes[elem] = node_;
+        return elem;
+    }
+
+    // Appends a copy of the elem in position pos of src, links are not translated
+    void AppendElem(const BasicRCCode& src, unsigned pos) {
+        rows.push_back(src.rows[pos]);
+        cols.push_back(src.cols[pos]);
+        left_chains.push_back(src.left_chains[pos]);
+        right_chains.push_back(src.right_chains[pos]);
+        next_links.push_back(src.next_links[pos]);
+        if (Topology::kEnabled) {
+            nodes.push_back(src.nodes[pos]);
+        }
+        value_count++;
+    }
+
+    void Reserve(size_t n) {
+        rows.reserve(n);
+        cols.reserve(n);
+        left_chains.reserve(n);
+        right_chains.reserve(n);
+        next_links.reserve(n);
+        if (Topology::kEnabled) {
+            nodes.reserve(n);
+        }
+    }
+
+    size_t Size() const {
+        return value_count;
+    }
+
+    ElemRef operator[](unsigned pos) { return ElemRef(*this, pos); }
+    ConstElemRef operator[](unsigned pos) const { return ConstElemRef(*this, pos); }
+
+    unsigned Row(unsigned pos) const { return rows[pos]; }
+    unsigned Col(unsigned pos) const { return cols[pos]; }
+    unsigned Next(unsigned pos) const { return next_links[pos]; }
+    const Chain& Left(unsigned pos) const { return left_chains[pos]; }
+    const Chain& Right(unsigned pos) const { return right_chains[pos]; }
+
+    void Clean() {
+        rows = std::vector<unsigned>();
+        cols = std::vector<unsigned>();
+        left_chains = std::vector<Chain>();
+        right_chains = std::vector<Chain>();
+        next_links = std::vector<unsigned>();
+        nodes = std::vector<unsigned>();
+        tree = RCNodeTree();
+    }
+
+private:
+    void ClearElems() {
+        rows.clear();
+        cols.clear();
+        left_chains.clear();
+        right_chains.clear();
+        next_links.clear();
+        nodes.clear();
+        value_count = 0;
+    }
+
+    void SwapElems(BasicRCCode& other) {
+        rows.swap(other.rows);
+        cols.swap(other.cols);
+        left_chains.swap(other.left_chains);
+        right_chains.swap(other.right_chains);
+        next_links.swap(other.next_links);
+        nodes.swap(other.nodes);
+    }
+
+    size_t ElemsCapacity() const {
+        return rows.capacity();
+    }
+
+public:
+
+#endif // BACCA_RCCODE_SOA
+
+    // Links the right chain of elem from to the left chain of elem to
+    void Connect(unsigned from, unsigned to) {
+        (*this)[from].next = to;
+        if (sink_) {
+            ConnectContours(from, to);
+        }
+    }
+
+    // Node of the contour elem belongs to, which is also stored back in the elem
+    unsigned Node(unsigned elem) {
+        static_assert(Topology::kEnabled, "Nodes are only stored when topology is retrieved");
+        const unsigned node = tree.Find((*this)[elem].node);
+        (*this)[elem].node = node;
+        return node;
+    }
+
+    // Chains are stored in an arena owned by the RCCode itself
+    BasicRCCode() : owned_arena_(std::make_unique<ChainArena>()), arena_(owned_arena_.get()) {
+        if (Topology::kEnabled) {
+            tree.Reset();
+        }
+    }
+
+    // Chains are stored in an external arena, which is reset here and must outlive the RCCode
+    BasicRCCode(ChainArena& arena) : arena_(&arena) {
+        arena_->Reset();
+        if (Topology::kEnabled) {
+            tree.Reset();
+        }
+    }
+
+    // As above, but every contour is handed to sink, which must outlive the RCCode, as soon as
+    // Connect() closes it. Its elems are then freed and reused by the following max points, so
+    // Size() also counts free elems and is back to zero once all the contours have been closed.
+    BasicRCCode(ChainArena& arena, const ContourSink& sink) : BasicRCCode(arena) {
+        static_assert(!Topology::kEnabled, "Contours are not handed over when topology is retrieved");
+        if (sink) {
+            sink_ = &sink;
+        }
+    }
+
+    // Chains are stored in the arena of workspace, which must outlive the RCCode. The storage of
+    // the elems is also borrowed from workspace, with the capacity reached on previous images,
+    // and given back by the destructor.
+    explicit BasicRCCode(RCCodeWorkspace& workspace);
+    BasicRCCode(RCCodeWorkspace& workspace, const ContourSink& sink);
+
+    BasicRCCode(BasicRCCode&&) = default;
+    // The storage held so far is given back to its workspace, as done by the destructor
+    BasicRCCode& operator=(BasicRCCode&& other);
+    ~BasicRCCode();
+
+    // Empties the RCCode, but keeps the capacity of its storage
+    void ClearStorage() {
+        ClearElems();
+        if (Topology::kEnabled) {
+            tree.Reset();
+        }
+        contours_.clear();
+        open_chains_.clear();
+        created_.clear();
+        free_elems_.clear();
+        n_created_ = 0;
+        n_live_ = 0;
+    }
+
+    void SwapStorage(BasicRCCode& other) {
+        SwapElems(other);
+        tree.Swap(other.tree);
+        contours_.swap(other.contours_);
+        open_chains_.swap(other.open_chains_);
+        created_.swap(other.created_);
+        free_elems_.swap(other.free_elems_);
+    }
+
+    // Number of elems that can be stored without growing
+    size_t StorageCapacity() const {
+        return ElemsCapacity();
+    }
+
+    // Empties the RCCode for the next image, as a workspace does: the storage of the elems is kept
+    // if it holds at most max_elems elems, and the arena keeps at most max_chain_words words
+    void Recycle(size_t max_elems, size_t max_chain_words) {
+        ClearStorage();
+        if (StorageCapacity() > max_elems) {
+            Clean();
+        }
+        arena_->Trim(max_chain_words);
+    }
+
+private:
+    std::unique_ptr<ChainArena> owned_arena_;
+    ChainArena* arena_;
+
+    // Workspace the storage is given back to on destruction, cleared when the RCCode is moved
+    struct Lease {
+        RCCodeWorkspace* workspace = nullptr;
+
+        Lease() {}
+        Lease(Lease&& other) noexcept : workspace(other.workspace) { other.workspace = nullptr; }
+        Lease& operator=(Lease&& other) noexcept {
+            workspace = other.workspace;
+            other.workspace = nullptr;
+            return *this;
+        }
+    };
+    Lease lease_;
+
+    // Gives the storage back to the workspace it was borrowed from, if any, and ends the lease
+    void ReturnStorage();
+
+    // Contours being built, only tracked when a sink is given
+    const ContourSink* sink_ = nullptr;
+    std::vector<unsigned> contours_;        // union-find parent of each elem, roots are the first elem created in each contour
+    std::vector<unsigned> open_chains_;     // chains of the contour not connected yet, meaningful for roots only
+    std::vector<unsigned> created_;         // creation order of each elem
+    std::vector<unsigned> free_elems_;
+    unsigned n_created_ = 0;
+    unsigned n_live_ = 0;
+
+    void TrackElem(unsigned elem) {
+        if (elem == contours_.size()) {
+            contours_.push_back(elem);
+            open_chains_.push_back(2);
+            created_.push_back(n_created_++);
+        }
+        else {
+            contours_[elem] = elem;
+            open_chains_[elem] = 2;
+            created_[elem] = n_created_++;
+        }
+        n_live_++;
+    }
+
+    unsigned FindContour(unsigned elem) {
+        while (contours_[elem] != elem) {
+            contours_[elem] = contours_[contours_[elem]];
+            elem = contours_[elem];
+        }
+        return elem;
+    }
+
+    void ConnectContours(unsigned from, unsigned to) {
+        unsigned first = FindContour(from);
+        unsigned other = FindContour(to);
+        if (first != other) {
+            if (created_[other] < created_[first]) {
+                std::swap(first, other);
+            }
+            contours_[other] = first;
+            open_chains_[first] += open_chains_[other];
+        }
+        open_chains_[first] -= 2;
+        if (open_chains_[first] == 0) {
+            EmitContour(first);
+        }
+    }
+
+    // Hands the closed contour starting from elem first to the sink, in the same form given
+    // by RCCodeToChainCode(), then frees its elems
+    void EmitContour(unsigned first) {
+        ChainCode::Chain chain(Row(first), Col(first));
+        chain.AddRightChain(Right(first));
+        for (unsigned pos = Next(first); pos != first; pos = Next(pos)) {
+            chain.AddLeftChain(Left(pos));
+            chain.AddRightChain(Right(pos));
+        }
+        chain.AddLeftChain(Left(first));
+        (*sink_)(std::move(chain));
+
+        unsigned pos = first;
+        do {
+            const unsigned next = Next(pos);
+            (*this)[pos].left.Release();
+            (*this)[pos].right.Release();
+            free_elems_.push_back(pos);
+            n_live_--;
+            pos = next;
+        } while (pos != first);
+
+        if (n_live_ == 0) {
+            ClearElems();
+            free_elems_.clear();
+            contours_.clear();
+            open_chains_.clear();
+            created_.clear();
+            n_created_ = 0;
+        }
+    }
+
+public:
+    int value_count = 0;
+#ifndef BACCA_RCCODE_SOA
+    std::vector<MaxPoint> data;
+#else
+    std::vector<unsigned> rows, cols;
+    std::vector<Chain> left_chains, right_chains;
+    std::vector<unsigned> next_links;   // see MaxPoint::next
+    std::vector<unsigned> nodes;        // see MaxPoint::node, only with topology
+#endif
+    RCNodeTree tree;                    // tree of contours, only with topology
+};
+
+using RCCode = BasicRCCode<NoTopology>;
+using RCCodeTopology = BasicRCCode<WithTopology>;
+
+// Storage kept by an algorithm from one image to the next: the arena of the chains and the elems
+// of the RCCodes, which are lent to the RCCodes built on the workspace. Once an image is done,
+// the storage is kept only if it holds at most max_retained_elems elems, and released otherwise,
+// so that a single huge image does not hold memory for all the following ones. In the same way,
+// the arena keeps at most max_retained_chain_words words of chains, released when the next RCCode
+// is built on the workspace.
+class RCCodeWorkspace {
+public:
+    ChainArena chain_arena;
+    size_t max_retained_elems = std::numeric_limits<size_t>::max();
+    size_t max_retained_chain_words = std::numeric_limits<size_t>::max();
+
+    template <typename Topology>
+    BasicRCCode<Topology>& Spare();
+
+    // Releases all the storage kept so far
+    void Clean() {
+        rccode_ = RCCode();
+        rccode_topology_ = RCCodeTopology();
+    }
+
+private:
+    RCCode rccode_;
+    RCCodeTopology rccode_topology_;
+};
+
+template <>
+inline RCCode& RCCodeWorkspace::Spare<NoTopology>() { return rccode_; }
+template <>
+inline RCCodeTopology& RCCodeWorkspace::Spare<WithTopology>() { return rccode_topology_; }
+
+template <typename Topology>
+BasicRCCode<Topology>::BasicRCCode(RCCodeWorkspace& workspace) : BasicRCCode(workspace.chain_arena) {
+    workspace.chain_arena.Trim(workspace.max_retained_chain_words);
+    SwapStorage(workspace.Spare<Topology>());
+    ClearStorage();
+    lease_.workspace = &workspace;
+}
+
+template <typename Topology>
+BasicRCCode<Topology>::BasicRCCode(RCCodeWorkspace& workspace, const ContourSink& sink) : BasicRCCode(workspace) {
+    static_assert(!Topology::kEnabled, "Contours are not handed over when topology is retrieved");
+    if (sink) {
+        sink_ = &sink;
+    }
+}
+
+template <typename Topology>
+void BasicRCCode<Topology>::ReturnStorage() {
+    if (lease_.workspace) {
+        BasicRCCode& spare = lease_.workspace->template Spare<Topology>();
+        if (StorageCapacity() <= lease_.workspace->max_retained_elems && StorageCapacity() >= spare.StorageCapacity()) {
+            ClearStorage();
+            SwapStorage(spare);
+        }
+        lease_.workspace = nullptr;
+    }
+}
+
+template <typename Topology>
+BasicRCCode<Topology>& BasicRCCode<Topology>::operator=(BasicRCCode&& other) {
+    if (this != &other) {
+        ReturnStorage();
+        SwapStorage(other);
+        owned_arena_ = std::move(other.owned_arena_);
+        arena_ = other.arena_;
+        lease_ = std::move(other.lease_);
+        sink_ = other.sink_;
+        n_created_ = other.n_created_;
+        n_live_ = other.n_live_;
+        value_count = other.value_count;
+    }
+    return *this;
+}
+
+template <typename Topology>
+BasicRCCode<Topology>::~BasicRCCode() {
+    ReturnStorage();
+}
+
+
+void RCCodeToChainCode(const RCCodeTopology& rccode, ChainCode& chcode, std::vector<cv::Vec4i>& hierarchy);
+
+// Converts only the contours selected by retrieval. The other ones are not visited at all, so the
+// conversion time depends on the contours kept. Their hierarchy is a flat list of siblings.
+void RCCodeToChainCode(const RCCodeTopology& rccode, ChainCode& chcode, std::vector<cv::Vec4i>& hierarchy, ContourRetrieval retrieval);
 
-void RCCodeToChainCode(const RCCode& rccode, ChainCode& chcode, std::vector<cv::Vec4i>& hierarchy);
 void RCCodeToChainCode(const RCCode& rccode, ChainCode& chcode);
 
+// Same as above, with the contours converted over n_threads threads (the calling one included).
+// A first pass follows the links between max points to find the contours and their lengths, so
+// that each of them is then built in its own slot of chcode, independently of the others.
+void RCCodeToChainCode(const RCCode& rccode, ChainCode& chcode, unsigned n_threads);
+void RCCodeToChainCode(const RCCodeTopology& rccode, ChainCode& chcode, std::vector<cv::Vec4i>& hierarchy, unsigned n_threads);
+
+// Same as above, storing the contours in flat. The values of every contour are counted first, so
+// that the values of flat are allocated once and each contour is written in place.
+void RCCodeToChainCode(const RCCode& rccode, FlatChainCode& flat, unsigned n_threads = 1);
+void RCCodeToChainCode(const RCCodeTopology& rccode, FlatChainCode& flat, std::vector<cv::Vec4i>& hierarchy,
+    ContourRetrieval retrieval = ContourRetrieval::All, unsigned n_threads = 1);
+
+// Same as above, storing the points of every contour as cv::findContours does with CHAIN_APPROX_NONE.
+// Points are computed from the links of the chains, without building the Freeman values. Each contour
+// runs in the direction of OpenCV from its top-left point, where OpenCV starts outer contours but not
+// always holes. The vectors of contours are resized, so their memory is reused when the same contours
+// are passed again.
+void RCCodeToContours(const RCCode& rccode, std::vector<std::vector<cv::Point>>& contours, unsigned n_threads = 1);
+void RCCodeToContours(const RCCodeTopology& rccode, std::vector<std::vector<cv::Point>>& contours, std::vector<cv::Vec4i>& hierarchy,
+    ContourRetrieval retrieval = ContourRetrieval::All, unsigned n_threads = 1);
+
+// Result of the algorithms based on the RCCode which is converted only on demand, see
+// ChainCodeAlg::SetLazyOutput(). The elems of the RCCode are kept, and a first pass over them finds
+// every contour, with its start point and number of values, without decoding any link. Each chain
+// is decoded when asked for. Chains live in the arena of the algorithm, so the result is valid
+// until the algorithm runs again.
+class LazyChainCode {
+
+    RCCode rccode_;
+    std::vector<unsigned> heads_;           // first max point of each contour
+    std::vector<size_t> value_counts_;
+    std::vector<int> used_elems_;
+    size_t total_values_ = 0;
+    mutable size_t decoded_values_ = 0;
+
+public:
+    // Takes the elems of rccode and finds its contours
+    void Reset(RCCode&& rccode);
+
+    // Gives the elems back to their workspace, keeping the memory of the lists of contours
+    void Clear();
+
+    size_t Size() const { return heads_.size(); }
+    unsigned Row(size_t i) const { return rccode_.Row(heads_[i]); }
+    unsigned Col(size_t i) const { return rccode_.Col(heads_[i]); }
+    size_t ValueCount(size_t i) const { return value_counts_[i]; }
+
+    // Decodes contour i, or all of them
+    ChainCode::Chain Decode(size_t i) const;
+    ChainCode ToChainCode() const;
+    void ToFlatChainCode(FlatChainCode& flat) const;
+
+    // Values of all the contours, and how many of them have been decoded so far
+    size_t TotalValues() const { return total_values_; }
+    size_t DecodedValues() const { return decoded_values_; }
+};
+
+// Merges the RCCodes computed on consecutive horizontal strips of the same image into rccode.
+// The first incoming_chains[s] elems of strips[s] are placeholders for the chains that enter
+// strip s from above: the i-th placeholder continues the chain stored in outgoing_chains[s - 1][i],
+// that is the i-th chain left open at the bottom of the previous strip. Real elems are appended
+// in strip order, so the result is the same RCCode the serial scan would have built.
+// Chains of the merged elems keep their words in the arenas of the strips, which must outlive rccode.
+// The strips are emptied, but keep the capacity of their storage.
+void MergeRCCodeStrips(std::vector<RCCode>& strips, const std::vector<unsigned>& incoming_chains,
+    const std::vector<std::vector<unsigned>>& outgoing_chains, RCCode& rccode);
+
 bool CheckHierarchy(const std::vector<cv::Vec4i>& hierarchy);
 
+// Hierarchy of n_contours contours which are all siblings, as given by RETR_LIST
+void SiblingsHierarchy(std::vector<cv::Vec4i>& hierarchy, size_t n_contours);
+
 void SortChains(ChainCode& chcode);
 void SortChains(ChainCode& chcode, std::vector<cv::Vec4i>& hierarchy);
 
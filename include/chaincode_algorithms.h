@@ -7,8 +7,12 @@
 #ifndef BACCA_CHAIN_CODE_ALGORITHMS_H_
 #define BACCA_CHAIN_CODE_ALGORITHMS_H_
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -19,7 +23,8 @@
 
 class ChainCodeAlg {
 public:
-    static cv::Mat1b img_;
+    // Input image, owned by each instance so that different instances can run at the same time
+    cv::Mat1b img_;
 
     bool with_hierarchy_ = false;
     ChainCode chain_code_;
@@ -27,6 +32,31 @@ public:
 
     PerformanceEvaluator perf_;
 
+    // Storage for the RCCode, reused from one image to the next
+    RCCodeWorkspace workspace_;
+
+    // Contours the output keeps room for from one image to the next, see FreeChainCodeData()
+    size_t max_retained_contours_ = std::numeric_limits<size_t>::max();
+
+    // When set, receives the contours in place of chain_code_, see SetContourSink()
+    ContourSink contour_sink_;
+
+    // Contours stored in chain_code_ and hierarchy_, see SetContourRetrieval()
+    ContourRetrieval retrieval_ = ContourRetrieval::All;
+
+    // When set, the contours are stored in flat_chain_code_ in place of chain_code_, as all the
+    // algorithms do by default, see SetFlatOutput()
+    bool flat_output_ = true;
+    FlatChainCode flat_chain_code_;
+
+    // When set, the RCCode is kept in lazy_chain_code_ in place of chain_code_, see SetLazyOutput()
+    bool lazy_output_ = false;
+    LazyChainCode lazy_chain_code_;
+
+    // When set, the points of the contours are stored in contours_ in place of chain_code_, see SetPointsOutput()
+    bool points_output_ = false;
+    std::vector<std::vector<cv::Point>> contours_;
+
     ChainCodeAlg() {}
     virtual ~ChainCodeAlg() = default;
 
@@ -34,16 +64,115 @@ public:
     virtual void PerformChainCodeWithSteps() { throw std::runtime_error("'PerformChainCodeWithSteps()' not implemented"); }
     virtual void PerformChainCodeMem(std::vector<uint64_t>& accesses) { throw std::runtime_error("'PerformChainCodeMem(...)' not implemented"); }
 
-    virtual void FreeChainCodeData() { chain_code_.Clean(); hierarchy_.clear(); hierarchy_.shrink_to_fit(); }
+    // Only parallel algorithms can be asked to use a specific number of threads
+    virtual void SetThreadsNumber(unsigned n_threads) { throw std::runtime_error("'SetThreadsNumber(...)' not implemented"); }
+
+    // Only streaming algorithms can be fed one row at a time: StartStream() begins an image of the given
+    // width, PushRow() adds its rows from top to bottom and FinishStream() stores the result as PerformChainCode() does
+    virtual void StartStream(unsigned width) { throw std::runtime_error("'StartStream(...)' not implemented"); }
+    virtual void PushRow(const uint8_t* row) { throw std::runtime_error("'PushRow(...)' not implemented"); }
+    virtual void FinishStream() { throw std::runtime_error("'FinishStream()' not implemented"); }
+
+    // Only algorithms building the RCCode of the whole image can hand each contour to a sink as soon as the
+    // scan closes it, instead of storing it in the output. The max points of a contour are released right
+    // after, so memory only depends on the contours open at the same time. An empty sink restores the output.
+    virtual void SetContourSink(ContourSink sink) { throw std::runtime_error("'SetContourSink(...)' not implemented"); }
+
+    // Only algorithms retrieving the hierarchy can keep the outer contours or the holes alone, since
+    // they are told apart by the tree of contours. The scan is the same, while the contours which are
+    // not kept are skipped by the conversion.
+    virtual void SetContourRetrieval(ContourRetrieval retrieval) { throw std::runtime_error("'SetContourRetrieval(...)' not implemented"); }
+
+    // All the algorithms store the contours in a FlatChainCode by default, which takes a couple of
+    // allocations for the whole image instead of one per contour. SetFlatOutput(false) stores them
+    // in chain_code_ instead.
+    virtual void SetFlatOutput(bool flat) { flat_output_ = flat; }
+
+    // Only algorithms building the RCCode without the hierarchy can leave its conversion to the consumer,
+    // which decodes just the contours it needs from lazy_chain_code_. The CONVERSION step then only
+    // finds the contours and their lengths.
+    virtual void SetLazyOutput(bool lazy) { throw std::runtime_error("'SetLazyOutput(...)' not implemented"); }
+
+    // Only algorithms building the RCCode can store the contours as the points given by cv::findContours,
+    // which are followed straight from the chains of the RCCode, see RCCodeToContours()
+    virtual void SetPointsOutput(bool points) { throw std::runtime_error("'SetPointsOutput(...)' not implemented"); }
+
+    // Stores the contours of rccode in chain_code_, or in flat_chain_code_ when flat_output_ is set, or
+    // in contours_ when points_output_ is set, over n_threads threads. When lazy_output_ is set, rccode
+    // is moved to lazy_chain_code_ instead.
+    // The hierarchy of an RCCodeTopology goes to hierarchy_, with the contours selected by retrieval_.
+    void StoreContours(RCCode& rccode, unsigned n_threads = 1);
+    void StoreContours(const RCCodeTopology& rccode, unsigned n_threads = 1);
+
+    // Stores the contours found by cv::findContours, or in its order when contrary is set, in
+    // chain_code_, or in flat_chain_code_ when flat_output_ is set
+    void StoreContours(const std::vector<std::vector<cv::Point>>& cv_contours, bool contrary);
+
+    // Contours of the last image as a ChainCode, for code which compares or keeps them: chain_code_ is
+    // moved, while the other outputs are converted. Call FreeChainCodeData() before the next image.
+    ChainCode TakeChainCode();
+
+    // Contours of the last image as a FlatChainCode, for code which keeps them without a vector per
+    // contour: flat_chain_code_ is moved, while the other outputs are converted. Call FreeChainCodeData()
+    // before the next image.
+    FlatChainCode TakeFlatChainCode();
+
+    // The output is cleared, but its capacity is kept for the next image as long as it holds at most
+    // max_retained_contours_ contours, as the workspace does with max_retained_elems elems
+    virtual void FreeChainCodeData() {
+        if (std::max(chain_code_.chains.capacity(), hierarchy_.capacity()) <= max_retained_contours_) {
+            chain_code_.chains.clear();
+            hierarchy_.clear();
+        }
+        else {
+            chain_code_.Clean();
+            hierarchy_.clear();
+            hierarchy_.shrink_to_fit();
+        }
+        flat_chain_code_.Clear();
+        if (flat_chain_code_.contours.capacity() > max_retained_contours_) {
+            flat_chain_code_ = FlatChainCode();
+        }
+        lazy_chain_code_.Clear();
+        contours_.clear();
+        if (contours_.capacity() > max_retained_contours_) {
+            contours_.shrink_to_fit();
+        }
+    }
 
 };
 
+// Base of the algorithms building the RCCode, whose contours can be stored in any of the forms the
+// RCCode is converted to, see StoreContours()
+class RCCodeChainCodeAlg : public ChainCodeAlg {
+public:
+    virtual void SetPointsOutput(bool points) override { points_output_ = points; }
+};
+
+// Algorithms building the RCCode without the hierarchy, which can hand the RCCode over as it is, or
+// each contour to a sink as soon as the scan closes it
+class RCCodeListChainCodeAlg : public RCCodeChainCodeAlg {
+public:
+    virtual void SetContourSink(ContourSink sink) override { contour_sink_ = std::move(sink); }
+    virtual void SetLazyOutput(bool lazy) override { lazy_output_ = lazy; }
+};
+
+// Algorithms building the RCCode with the hierarchy, which can keep some of the contours alone
+class RCCodeTreeChainCodeAlg : public RCCodeChainCodeAlg {
+public:
+    virtual void SetContourRetrieval(ContourRetrieval retrieval) override { retrieval_ = retrieval; }
+};
+
 class ChainCodeAlgMapSingleton {
 public:
     std::map<std::string, ChainCodeAlg*> data_;
 
+    // Make new instances of the registered algorithms, independent of the ones in data_
+    std::map<std::string, std::function<ChainCodeAlg*()>> factories_;
+
     static ChainCodeAlgMapSingleton& GetInstance();
     static ChainCodeAlg* GetChainCodeAlg(const std::string& s);
+    static std::unique_ptr<ChainCodeAlg> NewChainCodeAlg(const std::string& s);
     static bool Exists(const std::string& s);
     ChainCodeAlgMapSingleton(ChainCodeAlgMapSingleton const&) = delete;
     void operator=(ChainCodeAlgMapSingleton const&) = delete;
@@ -57,6 +186,21 @@ private:
     }
 };
 
+// Output of an algorithm on one image of a batch
+struct BatchResult {
+    FlatChainCode flat_chain_code;
+    std::vector<cv::Vec4i> hierarchy;
+};
+
+// Runs the algorithm registered as alg_name on all the images, over n_threads threads. Each thread
+// works with its own instance of the algorithm, made by its factory and kept for all the images
+// it takes. Parallel algorithms are asked to use a single thread each. The algorithm must implement
+// PerformChainCode(). The contours are taken with TakeFlatChainCode(), so the flat output, which is the
+// default one, is handed over as it is, while those of lazy algorithms are all decoded, as a consumer
+// of the whole chain code would do. The first exception thrown by the algorithm is rethrown once all
+// the threads are done.
+std::vector<BatchResult> PerformChainCodeBatch(const std::string& alg_name, const std::vector<cv::Mat1b>& imgs, unsigned n_threads);
+
 enum StepType {
     ALGORITHM = 0,
     CONVERSION = 1,
@@ -7,102 +7,231 @@
 #ifndef BACCA_CHAINCODE_CEDERBERG_H_
 #define BACCA_CHAINCODE_CEDERBERG_H_
 
+#include "active_chains.h"
+#include "bit_image.h"
 #include "chaincode_algorithms.h"
+#include "padded_image.h"
+#include "parallel.h"
 
-class Cederberg : public ChainCodeAlg {
+// Algorithms are templated on the container of the active chains (see active_chains.h)
+template <typename ActiveChains>
+class Cederberg : public RCCodeListChainCodeAlg {
 
 public:
     virtual void PerformChainCode();
+};
+
+template <typename ActiveChains>
+class Cederberg_LUT : public RCCodeListChainCodeAlg {
 
-    virtual void FreeChainCodeData() {
-        ChainCodeAlg::FreeChainCodeData();
-    }
+public:
+    virtual void PerformChainCode();
+};
+
+// Cederberg and Cederberg_LUT on a copy of the image with a background border, which makes all
+// the checks on the neighborhood of the pixels unnecessary
+template <typename ActiveChains>
+class Cederberg_Padded : public RCCodeListChainCodeAlg {
+private:
+    PaddedImage padded_img_;
+
+public:
+    virtual void PerformChainCode();
 };
 
-class Cederberg_LUT : public ChainCodeAlg {
+template <typename ActiveChains>
+class Cederberg_LUT_Padded : public RCCodeListChainCodeAlg {
+private:
+    PaddedImage padded_img_;
 
 public:
     virtual void PerformChainCode();
+};
 
-    virtual void FreeChainCodeData() {
-        ChainCodeAlg::FreeChainCodeData();
-    }
+template <typename ActiveChains>
+class Cederberg_LUT_PRED : public RCCodeListChainCodeAlg {
+
+public:
+    virtual void PerformChainCode();
 };
 
-class Cederberg_LUT_PRED : public ChainCodeAlg {
+// Cederberg_LUT_PRED on a copy of the image with 1 bit per pixel, which also jumps over the
+// background 64 columns at a time
+template <typename ActiveChains>
+class Cederberg_Packed : public RCCodeListChainCodeAlg {
+private:
+    BitImage packed_img_;
 
 public:
     virtual void PerformChainCode();
+};
 
-    virtual void FreeChainCodeData() {
-        ChainCodeAlg::FreeChainCodeData();
-    }
+// Cederberg_LUT on a copy of the image with 1 bit per pixel, from which the mask of the pixels
+// which do something is computed 64 pixels at a time: only the set bits of the mask are visited
+template <typename ActiveChains>
+class Cederberg_EdgeMask : public RCCodeListChainCodeAlg {
+private:
+    BitImage packed_img_;
+
+public:
+    virtual void PerformChainCode();
+};
+
+// Pixel which does something in the raster scan, with its condition, see Cederberg_TwoPhase
+struct PixelEvent {
+    int col;
+    unsigned short condition;
+};
+
+// Cederberg_LUT in two phases for each row: the conditions of its pixels are first computed
+// 32 at a time with AVX2 when BACCA_AVX2 is set, or 16 at a time with SSE2 otherwise, keeping
+// only those which do something, then the chains are updated for those pixels only
+template <typename ActiveChains>
+class Cederberg_TwoPhase : public RCCodeListChainCodeAlg {
+private:
+    std::vector<uint8_t> background_row_;
+    std::vector<PixelEvent> events_;
+
+public:
+    virtual void PerformChainCode();
+};
+
+// Cederberg_LUT on two rows at a time: a window of four rows is scanned once, taking the actions
+// of the upper row as they come and those of the lower row at the end of the scan. Every pixel
+// with an action still goes through the table of Cederberg_LUT, so only the windows which are all
+// background or all foreground are saved, and dense images are slower than with Cederberg_Spaghetti.
+template <typename ActiveChains>
+class Cederberg_LUT_TwoRows : public RCCodeListChainCodeAlg {
+private:
+    std::vector<uint8_t> background_row_;
+    std::vector<PixelEvent> events_;
+
+public:
+    virtual void PerformChainCode();
 };
 
-class Cederberg_DRAG : public ChainCodeAlg {
+template <typename ActiveChains>
+class Cederberg_DRAG : public RCCodeListChainCodeAlg {
 private:
 
     RCCode PerformRCCode();
-    void ConvertToChainCode(const RCCode& rccode);
+    void ConvertToChainCode(RCCode& rccode);
 
 public:
     virtual void PerformChainCode() override;
     
     virtual void PerformChainCodeWithSteps() override;
+};
+
 
-    virtual void FreeChainCodeData() {
-        ChainCodeAlg::FreeChainCodeData();
-    }
+template <typename ActiveChains>
+class Cederberg_Tree : public RCCodeListChainCodeAlg {
+public:
+	virtual void PerformChainCode() override;
 };
 
 
-class Cederberg_Tree : public ChainCodeAlg {
+
+template <typename ActiveChains>
+class Cederberg_Spaghetti : public RCCodeListChainCodeAlg {
+private:
+	RCCode PerformRCCode();
+
 public:
 	virtual void PerformChainCode() override;
-	
-	virtual void FreeChainCodeData() {
-		ChainCodeAlg::FreeChainCodeData();
-	}
+
+	virtual void PerformChainCodeWithSteps() override;
 };
 
 
+// Cederberg_Spaghetti on horizontal strips scanned in parallel, whose open chains are then
+// stitched together across strip borders. The result is the same RCCode of the serial scan.
+template <typename ActiveChains>
+class Cederberg_Spaghetti_MT : public RCCodeListChainCodeAlg {
+private:
+	unsigned n_threads_ = DefaultThreadsNumber();
+	// RCCode of each strip, with the arena of its chains, kept alive until the merged RCCode has been
+	// converted and reused by the following images
+	std::vector<RCCode> strips_;
 
-class Cederberg_Spaghetti : public ChainCodeAlg {
 public:
 	virtual void PerformChainCode() override;
 
-	virtual void FreeChainCodeData() {
-		ChainCodeAlg::FreeChainCodeData();
+	virtual void SetThreadsNumber(unsigned n_threads) override {
+		n_threads_ = n_threads;
 	}
+
+	// Contours are closed while the strips are merged, after the scan, so they cannot be handed to a sink
+	virtual void SetContourSink(ContourSink sink) override { throw std::runtime_error("'SetContourSink(...)' not implemented"); }
 };
 
 
-class Cederberg_Spaghetti_FREQ_All : public ChainCodeAlg {
+// Cederberg_Spaghetti fed one row at a time, e.g. by a line-scan camera, through StartStream(),
+// PushRow() and FinishStream(). Only a window of three rows of pixels is kept, but the contours closed
+// so far stay in the RCCode until FinishStream(): the memory needed only depends on the width and on
+// the contours still open when a sink takes the closed ones, see SetContourSink(). PerformChainCode()
+// streams the rows of img_.
+template <typename ActiveChains>
+class Cederberg_Spaghetti_Stream : public RCCodeListChainCodeAlg {
+private:
+	int w_ = 0;
+	int n_rows_ = 0;					// rows pushed so far
+	std::vector<uint8_t> rows_[3];		// last rows pushed, the newest one in rows_[2]
+	RCCode rccode_;
+	ActiveChains chains_;
+
 public:
 	virtual void PerformChainCode() override;
 
-	virtual void FreeChainCodeData() {
-		ChainCodeAlg::FreeChainCodeData();
-	}
+	virtual void StartStream(unsigned width) override;
+	virtual void PushRow(const uint8_t* row) override;
+	virtual void FinishStream() override;
 };
 
-class Cederberg_Spaghetti_FREQ_AllNoClassical : public ChainCodeAlg {
+
+template <typename ActiveChains>
+class Cederberg_Spaghetti_FREQ_All : public RCCodeListChainCodeAlg {
 public:
 	virtual void PerformChainCode() override;
+};
 
-	virtual void FreeChainCodeData() {
-		ChainCodeAlg::FreeChainCodeData();
-	}
+template <typename ActiveChains>
+class Cederberg_Spaghetti_FREQ_AllNoClassical : public RCCodeListChainCodeAlg {
+public:
+	virtual void PerformChainCode() override;
 };
 
 
-class Cederberg_Spaghetti_FREQ_Hamlet : public ChainCodeAlg {
+template <typename ActiveChains>
+class Cederberg_Spaghetti_FREQ_Hamlet : public RCCodeListChainCodeAlg {
 public:
 	virtual void PerformChainCode() override;
+};
 
-	virtual void FreeChainCodeData() {
-		ChainCodeAlg::FreeChainCodeData();
-	}
+
+// Cederberg algorithms which also retrieve the hierarchy of contours, as SchefflerTopology does,
+// keeping the tree of contours up to date while the max points are added and their chains connected.
+template <typename ActiveChains>
+class Cederberg_Topology : public RCCodeTreeChainCodeAlg {
+public:
+	virtual void PerformChainCode() override;
+};
+
+template <typename ActiveChains>
+class Cederberg_Topology_LUT : public RCCodeTreeChainCodeAlg {
+public:
+	virtual void PerformChainCode() override;
+};
+
+template <typename ActiveChains>
+class Cederberg_Topology_Spaghetti : public RCCodeTreeChainCodeAlg {
+private:
+	RCCodeTopology PerformRCCode();
+
+public:
+	virtual void PerformChainCode() override;
+
+	virtual void PerformChainCodeWithSteps() override;
 };
 
 
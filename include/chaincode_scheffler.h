@@ -7,60 +7,144 @@
 #ifndef BACCA_CHAINCODE_SCHEFFLER_H_
 #define BACCA_CHAINCODE_SCHEFFLER_H_
 
+#include "active_chains.h"
+#include "bit_image.h"
 #include "chaincode_algorithms.h"
+#include "padded_image.h"
+#include "parallel.h"
 
 #include <memory>
 
-class Scheffler : public ChainCodeAlg {
+// Algorithms are templated on the container of the active chains (see active_chains.h)
+template <typename ActiveChains>
+class Scheffler : public RCCodeListChainCodeAlg {
 
 public:
     virtual void PerformChainCode() override;
+};
 
-    virtual void FreeChainCodeData() override {
-        ChainCodeAlg::FreeChainCodeData();
-    }
+template <typename ActiveChains>
+class Scheffler_LUT : public RCCodeListChainCodeAlg {
+
+public:
+    virtual void PerformChainCode() override;
 };
 
-class Scheffler_LUT : public ChainCodeAlg {
+template <typename ActiveChains>
+class Scheffler_LUT_PRED : public RCCodeListChainCodeAlg {
 
 public:
     virtual void PerformChainCode() override;
+};
 
-    virtual void FreeChainCodeData() override {
-        ChainCodeAlg::FreeChainCodeData();
-    }
+// Scheffler_LUT_PRED on a copy of the image with 1 bit per pixel, which also jumps over the
+// background 64 columns at a time
+template <typename ActiveChains>
+class Scheffler_Packed : public RCCodeListChainCodeAlg {
+private:
+    BitImage packed_img_;
+
+public:
+    virtual void PerformChainCode() override;
 };
 
-class Scheffler_LUT_PRED : public ChainCodeAlg {
+template <typename ActiveChains>
+class Scheffler_Spaghetti : public RCCodeListChainCodeAlg {
+private:
+    RCCode PerformRCCode();
 
 public:
     virtual void PerformChainCode() override;
 
-    virtual void FreeChainCodeData() override {
-        ChainCodeAlg::FreeChainCodeData();
-    }
+    virtual void PerformChainCodeWithSteps() override;
 };
 
-class Scheffler_Spaghetti : public ChainCodeAlg {
+// Scheffler_Spaghetti on horizontal strips scanned in parallel, whose open chains are then
+// stitched together across strip borders. The result is the same RCCode of the serial scan.
+template <typename ActiveChains>
+class Scheffler_Spaghetti_MT : public RCCodeListChainCodeAlg {
+private:
+    unsigned n_threads_ = DefaultThreadsNumber();
+    // RCCode of each strip, with the arena of its chains, kept alive until the merged RCCode has been
+    // converted and reused by the following images
+    std::vector<RCCode> strips_;
 
 public:
     virtual void PerformChainCode() override;
 
-    virtual void FreeChainCodeData() override {
-        ChainCodeAlg::FreeChainCodeData();
+    virtual void SetThreadsNumber(unsigned n_threads) override {
+        n_threads_ = n_threads;
     }
+
+    // Contours are closed while the strips are merged, after the scan, so they cannot be handed to a sink
+    virtual void SetContourSink(ContourSink sink) override { throw std::runtime_error("'SetContourSink(...)' not implemented"); }
 };
 
 
 
-class SchefflerTopology : public ChainCodeAlg {
+// Scheffler_Spaghetti fed one row at a time, e.g. by a line-scan camera, through StartStream(),
+// PushRow() and FinishStream(). Only a window of two rows of pixels is kept, but the contours closed
+// so far stay in the RCCode until FinishStream(): the memory needed only depends on the width and on
+// the contours still open when a sink takes the closed ones, see SetContourSink(). PerformChainCode()
+// streams the rows of img_.
+template <typename ActiveChains>
+class Scheffler_Spaghetti_Stream : public RCCodeListChainCodeAlg {
+private:
+    int w_ = 0;
+    int n_rows_ = 0;                    // rows pushed so far
+    std::vector<uint8_t> rows_[2];      // last rows pushed, the newest one in rows_[1]
+    RCCode rccode_;
+    ActiveChains chains_;
+
+public:
+    virtual void PerformChainCode() override;
+
+    virtual void StartStream(unsigned width) override;
+    virtual void PushRow(const uint8_t* row) override;
+    virtual void FinishStream() override;
+};
+
+template <typename ActiveChains>
+class SchefflerTopology : public RCCodeTreeChainCodeAlg {
 
 public:
     virtual void PerformChainCode();
+};
 
-    virtual void FreeChainCodeData() {
-        ChainCodeAlg::FreeChainCodeData();
-    }
+// SchefflerTopology on a copy of the image with a background border, without checks on the
+// neighborhood of the pixels
+template <typename ActiveChains>
+class SchefflerTopology_Padded : public RCCodeTreeChainCodeAlg {
+private:
+    PaddedImage padded_img_;
+
+public:
+    virtual void PerformChainCode();
+};
+
+template <typename ActiveChains>
+class SchefflerTopology_LUT : public RCCodeTreeChainCodeAlg {
+
+public:
+    virtual void PerformChainCode() override;
+};
+
+template <typename ActiveChains>
+class SchefflerTopology_LUT_PRED : public RCCodeTreeChainCodeAlg {
+
+public:
+    virtual void PerformChainCode() override;
+};
+
+template <typename ActiveChains>
+class SchefflerTopology_Spaghetti : public RCCodeTreeChainCodeAlg {
+private:
+    RCCodeTopology PerformRCCode();
+
+public:
+    virtual void PerformChainCode() override;
+
+    virtual void PerformChainCodeWithSteps() override;
 };
 
 
@@ -48,6 +48,42 @@ public:
 
 };
 
+// Outer contours alone, as given by RETR_EXTERNAL
+class SuzukiExternal : public ChainCodeAlg {
+
+private:
+
+    std::vector<std::vector<cv::Point>> FindContours();
+    void ConvertToChainCode(const std::vector<std::vector<cv::Point>>& cv_contours);
+
+public:
+    virtual void PerformChainCode() override;
+    virtual void PerformChainCodeWithSteps() override;
+
+    virtual void FreeChainCodeData() override {
+        ChainCodeAlg::FreeChainCodeData();
+    }
+
+};
+
+// Holes alone, taken from the second level of RETR_CCOMP
+class SuzukiHoles : public ChainCodeAlg {
+
+private:
+
+    std::vector<std::vector<cv::Point>> FindContours();
+    void ConvertToChainCode(const std::vector<std::vector<cv::Point>>& cv_contours);
+
+public:
+    virtual void PerformChainCode() override;
+    virtual void PerformChainCodeWithSteps() override;
+
+    virtual void FreeChainCodeData() override {
+        ChainCodeAlg::FreeChainCodeData();
+    }
+
+};
+
 
 
 #endif // BACCA_CHAINCODE_SUZUKI_H_
\ No newline at end of file
@@ -25,6 +25,10 @@ struct ConfigData {
     bool perform_average;                // Whether to perform average tests or not
     bool perform_memory;                 // Whether to perform memory tests or not
     bool perform_average_ws;             // Whether to perform average tests with steps or not
+    bool perform_scalability;            // Whether to perform scalability tests or not
+    bool perform_throughput;             // Whether to perform throughput tests or not
+    bool perform_open_chains;            // Whether to perform open chains tests or not
+    bool perform_allocations;            // Whether to perform allocations tests or not
 
     bool perform_check_std;              // Whether to perform correctness on PerformThinning() functions
     bool perform_check_ws;               // Whether to perform correctness on PerformThinningWithSteps() functions
@@ -36,6 +40,9 @@ struct ConfigData {
 
     unsigned average_tests_number;        // Reps of average tests (only the minimum will be considered)
     unsigned average_ws_tests_number;     // Reps of average tests with steps (only the minimum will be considered)
+    unsigned scalability_tests_number;    // Reps of scalability tests (only the minimum will be considered)
+    unsigned throughput_tests_number;     // Reps of throughput tests (only the minimum will be considered)
+    unsigned open_chains_tests_number;    // Reps of open chains tests (only the minimum will be considered)
 
     std::string input_txt;                // File of images list
     std::string gnuplot_script_extension; // Gnuplot scripts extension
@@ -46,10 +53,15 @@ struct ConfigData {
     std::string latex_memory_file;        // Latex file which will store textual memory results
     std::string latex_charts;             // Latex file which will store report latex code for charts
     std::string memory_file;              // File which will store report textual memory results
+    std::string allocations_file;         // File which will store textual allocations results
     
     std::string average_folder;           // Folder which will store average test results
     std::string average_ws_folder;        // Folder which will store average test with steps results
     std::string memory_folder;            // Folder which will store memory results
+    std::string scalability_folder;       // Folder which will store scalability results
+    std::string throughput_folder;        // Folder which will store throughput results
+    std::string open_chains_folder;       // Folder which will store open chains results
+    std::string allocations_folder;       // Folder which will store allocations results
 
     filesystem::path output_path;         // Path on which results are stored
     filesystem::path input_path;          // Path on which input datasets are stored
@@ -59,6 +71,12 @@ struct ConfigData {
     std::vector<cv::String> memory_datasets;      // List of datasets on which memory tests will be perform
     std::vector<cv::String> average_datasets;     // Lists of dataset on which average tests will be performed
     std::vector<cv::String> average_ws_datasets;  // Lists of dataset on which average tests whit steps will be performed
+    std::vector<cv::String> scalability_datasets; // Lists of dataset on which scalability tests will be performed
+    std::vector<cv::String> throughput_datasets;  // Lists of dataset on which throughput tests will be performed
+    std::vector<cv::String> allocations_datasets; // Lists of dataset on which allocations tests will be performed
+
+    std::vector<int> scalability_threads;         // Numbers of threads used by scalability tests
+    std::vector<int> throughput_threads;          // Numbers of threads used by throughput tests
 
     std::vector<AlgorithmNames> thin_algorithms;          // Lists of algorithms specified by the user in the config.yaml
     std::vector<AlgorithmNames> thin_existing_algorithms; // Lists of 'ccl_algorithms' actually existing
@@ -66,6 +84,7 @@ struct ConfigData {
 	std::vector<AlgorithmNames> thin_mem_algorithms;        // List of algorithms that actually support memory tests
     std::vector<AlgorithmNames> thin_average_algorithms;    // List of algorithms that actually support average tests
     std::vector<AlgorithmNames> thin_average_ws_algorithms; // List of algorithms that actually support average with steps tests
+    std::vector<AlgorithmNames> thin_scalability_algorithms; // List of algorithms that actually support scalability tests
     
     std::string bacca_os;               // Name of the current OS
 
@@ -0,0 +1,50 @@
+// Copyright (c) 2020, the BACCA contributors, as
+// shown by the AUTHORS file. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef BACCA_FIND_CONTOURS_FAST_H_
+#define BACCA_FIND_CONTOURS_FAST_H_
+
+#include <vector>
+
+#include <opencv2/imgproc.hpp>
+
+#include "chaincode_algorithms.h"
+
+// Replacement of cv::findContours with the same arguments. Nonzero pixels are foreground, as in OpenCV.
+// RETR_LIST uses Scheffler_Spaghetti and RETR_TREE uses Cederberg_Topology_Spaghetti, the fastest engines
+// for each mode, and the points are taken straight from their RCCode, see RCCodeToContours(). The contours
+// are the ones of OpenCV, in a different order, and holes may start from a different point. RETR_EXTERNAL
+// is left to cv::findContours, which only follows the outer borders while the raster scan traces every
+// contour, as are the other modes, other methods than CHAIN_APPROX_NONE and images other than CV_8UC1.
+// Each thread keeps its own engines, so that their storage is reused from one call to the next.
+void FindContoursFast(const cv::Mat& image, std::vector<std::vector<cv::Point>>& contours, std::vector<cv::Vec4i>& hierarchy,
+    int mode, int method, cv::Point offset = cv::Point());
+void FindContoursFast(const cv::Mat& image, std::vector<std::vector<cv::Point>>& contours,
+    int mode, int method, cv::Point offset = cv::Point());
+
+// FindContoursFast() in place of the cv::findContours of Suzuki, to compare the two: the ALGORITHM step
+// finds the points of the contours and the CONVERSION step turns them into the chain code, as in Suzuki.
+class FastContours : public ChainCodeAlg {
+private:
+    int mode_;
+
+    void FindContours();
+    void ConvertToChainCode();
+
+public:
+    FastContours(int mode = cv::RETR_LIST) : mode_(mode) {}
+
+    virtual void PerformChainCode() override;
+    virtual void PerformChainCodeWithSteps() override;
+};
+
+// Same as FastContours, compared with SuzukiTopology
+class FastContoursTopology : public FastContours {
+public:
+    FastContoursTopology() : FastContours(cv::RETR_TREE) {}
+};
+
+#endif // !BACCA_FIND_CONTOURS_FAST_H_
@@ -0,0 +1,51 @@
+// Copyright (c) 2020, the BACCA contributors, as
+// shown by the AUTHORS file. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef BACCA_PADDED_IMAGE_H_
+#define BACCA_PADDED_IMAGE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Copy of a binary image framed by a background border of one pixel, so that the neighborhood of
+// any pixel can be read without checks. The buffer is kept from one image to the next.
+class PaddedImage {
+
+    std::vector<uint8_t> pixels_;
+
+public:
+    int rows = 0;
+    int cols = 0;
+    size_t step = 0;
+
+    void Pad(const cv::Mat1b& img) {
+        rows = img.rows;
+        cols = img.cols;
+        step = static_cast<size_t>(cols) + 2;
+        pixels_.resize((static_cast<size_t>(rows) + 2) * step);
+
+        // Only the border is cleared, the rest is overwritten
+        std::fill_n(pixels_.begin(), step, uint8_t(0));
+        std::fill_n(pixels_.end() - step, step, uint8_t(0));
+        for (int r = 0; r < rows; r++) {
+            uint8_t* const row = pixels_.data() + (static_cast<size_t>(r) + 1) * step;
+            row[0] = 0;
+            std::memcpy(row + 1, img.ptr<uint8_t>(r), cols);
+            row[cols + 1] = 0;
+        }
+    }
+
+    // Pointer to column 0 of row r, with r from -1 to rows: columns -1 and cols can be read as well
+    const uint8_t* Row(int r) const {
+        return pixels_.data() + static_cast<size_t>(r + 1) * step + 1;
+    }
+};
+
+#endif // !BACCA_PADDED_IMAGE_H_
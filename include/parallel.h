@@ -0,0 +1,115 @@
+// Copyright (c) 2020, the BACCA contributors, as
+// shown by the AUTHORS file. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef BACCA_PARALLEL_H_
+#define BACCA_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads used by parallel algorithms when not specified otherwise
+inline unsigned DefaultThreadsNumber() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Joins the threads it is given when it goes out of scope, also when the calling thread throws
+class ThreadsJoiner {
+public:
+    explicit ThreadsJoiner(std::vector<std::thread>& threads) : threads_(threads) {}
+    ~ThreadsJoiner() {
+        for (auto& t : threads_) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+    ThreadsJoiner(const ThreadsJoiner&) = delete;
+    ThreadsJoiner& operator=(const ThreadsJoiner&) = delete;
+
+private:
+    std::vector<std::thread>& threads_;
+};
+
+// Calls worker(thread, failed) for every thread in [0, n_threads), the calling one included. The first
+// exception thrown by a worker is rethrown on the calling thread once all the threads are joined, and
+// failed is set as soon as it is thrown, so that the other workers can stop taking tasks.
+template <typename Worker>
+void RunWorkers(unsigned n_threads, const Worker& worker) {
+
+    std::atomic<bool> failed(false);
+    std::exception_ptr exception;
+    std::mutex exception_mutex;
+
+    auto guarded_worker = [&](unsigned thread) {
+        try {
+            worker(thread, failed);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(exception_mutex);
+            if (!exception) {
+                exception = std::current_exception();
+            }
+            failed = true;
+        }
+    };
+
+    {
+        std::vector<std::thread> threads;
+        ThreadsJoiner joiner(threads);
+
+        threads.reserve(n_threads - 1);
+        for (unsigned t = 1; t < n_threads; ++t) {
+            threads.emplace_back(guarded_worker, t);
+        }
+
+        guarded_worker(0);
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+// Calls body(i) for every i in [0, n_tasks), distributing the tasks over n_threads threads
+// (the calling one included). Task i is run by thread i % n_threads, so when n_tasks equals
+// n_threads every thread runs exactly one task. If body throws, the tasks not started yet are
+// skipped and the first exception is rethrown on the calling thread, see RunWorkers().
+template <typename Body>
+void ParallelFor(unsigned n_tasks, unsigned n_threads, const Body& body) {
+
+    n_threads = std::max(1u, std::min(n_threads, n_tasks));
+
+    RunWorkers(n_threads, [&body, n_tasks, n_threads](unsigned first, const std::atomic<bool>& failed) {
+        for (unsigned i = first; i < n_tasks && !failed; i += n_threads) {
+            body(i);
+        }
+    });
+}
+
+// Calls body(thread, i) for every i in [0, n_tasks), distributing the tasks over n_threads threads
+// (the calling one included), where thread is the index of the running thread. Threads take the
+// next task as soon as they are done with the previous one, so that tasks of uneven cost are
+// balanced. Exceptions are handled as in ParallelFor().
+template <typename Body>
+void ParallelForDynamic(unsigned n_tasks, unsigned n_threads, const Body& body) {
+
+    n_threads = std::max(1u, std::min(n_threads, n_tasks));
+
+    std::atomic<unsigned> next_task(0);
+
+    RunWorkers(n_threads, [&body, &next_task, n_tasks](unsigned thread, const std::atomic<bool>& failed) {
+        for (unsigned i = next_task++; i < n_tasks && !failed; i = next_task++) {
+            body(thread, i);
+        }
+    });
+}
+
+#endif // !BACCA_PARALLEL_H_
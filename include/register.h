@@ -12,9 +12,74 @@ class register_##algorithm {                                                   \
   public:                                                                      \
     register_##algorithm() {                                                   \
         ChainCodeAlgMapSingleton::GetInstance().data_[#algorithm] = new algorithm; \
+        ChainCodeAlgMapSingleton::GetInstance().factories_[#algorithm] = [] { return static_cast<ChainCodeAlg*>(new algorithm); }; \
     }                                                                          \
 } reg_##algorithm;
 
+// Registers an algorithm templated on the container of the active chains (see active_chains.h)
+// once for every container. The std::vector based one keeps the plain name of the algorithm.
+#define REGISTER_CHAINCODEALG_CHAINS(algorithm)                                                         \
+class register_##algorithm {                                                                            \
+  public:                                                                                               \
+    register_##algorithm() {                                                                            \
+        ChainCodeAlgMapSingleton::GetInstance().data_[#algorithm] = new algorithm<ChainsVector>;        \
+        ChainCodeAlgMapSingleton::GetInstance().data_[#algorithm "_GapBuffer"] = new algorithm<ChainsGapBuffer>; \
+        ChainCodeAlgMapSingleton::GetInstance().factories_[#algorithm] = [] { return static_cast<ChainCodeAlg*>(new algorithm<ChainsVector>); }; \
+        ChainCodeAlgMapSingleton::GetInstance().factories_[#algorithm "_GapBuffer"] = [] { return static_cast<ChainCodeAlg*>(new algorithm<ChainsGapBuffer>); }; \
+    }                                                                                                   \
+} reg_##algorithm;
+
+// Registers the std::vector based instances of an algorithm retrieving the hierarchy which keep the
+// outer contours alone (name_External) and the holes alone (name_Holes), see SetContourRetrieval()
+#define REGISTER_CHAINCODEALG_RETRIEVAL(algorithm)                                                      \
+class register_retrieval_##algorithm {                                                                  \
+    static ChainCodeAlg* New(ContourRetrieval retrieval) {                                              \
+        ChainCodeAlg* alg = new algorithm<ChainsVector>;                                                \
+        alg->SetContourRetrieval(retrieval);                                                            \
+        return alg;                                                                                     \
+    }                                                                                                   \
+  public:                                                                                               \
+    register_retrieval_##algorithm() {                                                                  \
+        ChainCodeAlgMapSingleton::GetInstance().data_[#algorithm "_External"] = New(ContourRetrieval::External); \
+        ChainCodeAlgMapSingleton::GetInstance().data_[#algorithm "_Holes"] = New(ContourRetrieval::Holes); \
+        ChainCodeAlgMapSingleton::GetInstance().factories_[#algorithm "_External"] = [] { return New(ContourRetrieval::External); }; \
+        ChainCodeAlgMapSingleton::GetInstance().factories_[#algorithm "_Holes"] = [] { return New(ContourRetrieval::Holes); }; \
+    }                                                                                                   \
+} reg_retrieval_##algorithm;
+
+// Registers the std::vector based instance of an algorithm which leaves the conversion of the RCCode
+// to the consumer (name_Lazy), see SetLazyOutput(). Compared with the plain algorithm in the tests
+// with steps, it shows how much of the CONVERSION step is avoided.
+#define REGISTER_CHAINCODEALG_LAZY(algorithm)                                                           \
+class register_lazy_##algorithm {                                                                       \
+    static ChainCodeAlg* New() {                                                                        \
+        ChainCodeAlg* alg = new algorithm<ChainsVector>;                                                \
+        alg->SetLazyOutput(true);                                                                       \
+        return alg;                                                                                     \
+    }                                                                                                   \
+  public:                                                                                               \
+    register_lazy_##algorithm() {                                                                       \
+        ChainCodeAlgMapSingleton::GetInstance().data_[#algorithm "_Lazy"] = New();                      \
+        ChainCodeAlgMapSingleton::GetInstance().factories_[#algorithm "_Lazy"] = [] { return New(); };  \
+    }                                                                                                   \
+} reg_lazy_##algorithm;
+
+// Registers the std::vector based instance of an algorithm which stores the contours in chain_code_,
+// with a vector per contour, instead of the default flat_chain_code_ (name_ChainCode), see SetFlatOutput()
+#define REGISTER_CHAINCODEALG_CHAINCODE(algorithm)                                                      \
+class register_chaincode_##algorithm {                                                                  \
+    static ChainCodeAlg* New() {                                                                        \
+        ChainCodeAlg* alg = new algorithm<ChainsVector>;                                                \
+        alg->SetFlatOutput(false);                                                                      \
+        return alg;                                                                                     \
+    }                                                                                                   \
+  public:                                                                                               \
+    register_chaincode_##algorithm() {                                                                  \
+        ChainCodeAlgMapSingleton::GetInstance().data_[#algorithm "_ChainCode"] = New();                 \
+        ChainCodeAlgMapSingleton::GetInstance().factories_[#algorithm "_ChainCode"] = [] { return New(); }; \
+    }                                                                                                   \
+} reg_chaincode_##algorithm;
+
 //#define STRINGIFY(x) #x
 //#define CONCAT(x,y) STRINGIFY(x ## _ ## y)
 //
@@ -0,0 +1,79 @@
+// Copyright (c) 2020, the BACCA contributors, as
+// shown by the AUTHORS file. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Without BACCA_COUNT_ALLOCATIONS the default operator new is kept, which does not pay for the count
+// on every allocation of every thread, and no allocation is counted
+
+namespace {
+
+std::atomic<uint64_t> allocations_number{ 0 };
+
+#ifdef BACCA_COUNT_ALLOCATIONS
+void* CountedAllocation(std::size_t size) noexcept {
+    allocations_number.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+#endif
+
+}
+
+uint64_t AllocationsNumber() {
+    return allocations_number.load(std::memory_order_relaxed);
+}
+
+#ifdef BACCA_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size) {
+    void* p = CountedAllocation(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return CountedAllocation(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return CountedAllocation(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+#endif // BACCA_COUNT_ALLOCATIONS
@@ -19,9 +19,11 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
 
+#include "allocation_counter.h"
 #include "chaincode_algorithms.h"
 #include "latex_generator.h"
 #include "memory_tester.h"
+#include "parallel.h"
 #include "utilities.h"
 
 using namespace cv;
@@ -294,7 +296,8 @@ void BACCATests::AverageTest()
                 path filename_path = dataset_path / path(filename);
 
                 // Read and load image
-                if (!GetBinaryImage(filename_path, ChainCodeAlg::img_)) {
+                Mat1b img;
+                if (!GetBinaryImage(filename_path, img)) {
                     ob.Cwarning("Unable to open '" + filename + "', skipped");
                     continue;
                 }
@@ -304,6 +307,7 @@ void BACCATests::AverageTest()
                 // For all the Algorithms in the array
                 for (const auto& algo_name : shuffled_thin_average_algorithms) {
                     ChainCodeAlg *algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(algo_name);
+                    algorithm->img_ = img;
                     unsigned i = algo_pos[algo_name];
 
                     try {
@@ -552,7 +556,8 @@ void BACCATests::AverageTestWithSteps()
                 path filename_path = dataset_path / path(filename);
 
                 // Read and load image
-                if (!GetBinaryImage(filename_path, ChainCodeAlg::img_)) {
+                Mat1b img;
+                if (!GetBinaryImage(filename_path, img)) {
                     ob.Cwarning("Unable to open '" + filename + "'");
                     continue;
                 }
@@ -562,6 +567,7 @@ void BACCATests::AverageTestWithSteps()
                 // For all the Algorithms in the array
                 for (const auto& algo_name : shuffled_thin_average_ws_algorithms) {
                     ChainCodeAlg *algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(algo_name);
+                    algorithm->img_ = img;
                     unsigned i = algo_pos[algo_name];
 
                     try {
@@ -803,7 +809,8 @@ void BACCATests::MemoryTest()
             path filename_path = dataset_path / path(filename);
 
             // Read and load image
-            if (!GetBinaryImage(filename_path, ChainCodeAlg::img_)) {
+            Mat1b img;
+            if (!GetBinaryImage(filename_path, img)) {
                 ob.Cwarning("Unable to open '" + filename + "'");
                 continue;
             }
@@ -813,6 +820,7 @@ void BACCATests::MemoryTest()
             // For all the Algorithms in the array
             for (unsigned i = 0; i < cfg_.thin_mem_algorithms.size(); ++i) {
                 ChainCodeAlg *algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(cfg_.thin_mem_algorithms[i].test_name);
+                algorithm->img_ = img;
 
                 // The following data_ structure is used to get the memory access matrices
                 vector<uint64_t> accesses; // Rows represents algorithms and columns represent data_ structures
@@ -862,6 +870,535 @@ void BACCATests::MemoryTest()
     os.close();
 }
 
+// Total execution time of every parallel algorithm on every dataset, repeated for each number
+// of threads in the 'scalability_threads' list. The speedup is relative to the first entry.
+void BACCATests::ScalabilityTest()
+{
+    OutputBox ob("Scalability Test");
+
+    const auto& threads = cfg_.scalability_threads;
+    const auto& algorithms = cfg_.thin_scalability_algorithms;
+
+    for (unsigned d = 0; d < cfg_.scalability_datasets.size(); ++d) { // For every dataset in the scalability list
+
+        String dataset_name(cfg_.scalability_datasets[d]),
+            output_scalability_results = dataset_name + "_scalability.txt",
+            output_graph = dataset_name + "_speedup" + kTerminalExtension;
+
+        path dataset_path(cfg_.input_path / path(dataset_name)),
+            is_path = dataset_path / path(cfg_.input_txt), // files.txt path
+            current_output_path(cfg_.output_path / path(cfg_.scalability_folder) / path(dataset_name)),
+            scalability_os_path = current_output_path / path(output_scalability_results);
+
+        if (!create_directories(current_output_path)) {
+            ob.Cwarning("Unable to find/create the output path '" + current_output_path.string() + "', skipped", dataset_name);
+            continue;
+        }
+
+        vector<pair<string, bool>> filenames;  // first: filename, second: state of filename (find or not)
+        if (!LoadFileList(filenames, is_path)) {
+            ob.Cwarning("Unable to open '" + is_path.string() + "', skipped", dataset_name);
+            continue;
+        }
+
+        unsigned filenames_size = static_cast<unsigned>(filenames.size());
+
+        // Rows represent numbers of threads, columns represent algorithms
+        Mat1d total_res(static_cast<int>(threads.size()), static_cast<int>(algorithms.size()), 0.0);
+
+        for (unsigned t = 0; t < threads.size(); ++t) {
+
+            for (const auto& algo_struct : algorithms) {
+                ChainCodeAlgMapSingleton::GetChainCodeAlg(algo_struct.test_name)->SetThreadsNumber(threads[t]);
+            }
+
+            ob.StartRepeatedBox(dataset_name + " (" + to_string(threads[t]) + " threads)", filenames_size, cfg_.scalability_tests_number);
+
+            Mat1d min_res(filenames_size, static_cast<int>(algorithms.size()), numeric_limits<double>::max());
+
+            for (unsigned test = 0; test < cfg_.scalability_tests_number; ++test) {
+                for (unsigned file = 0; file < filenames_size; ++file) {
+                    ob.UpdateRepeatedBox(file);
+
+                    string filename = filenames[file].first;
+                    path filename_path = dataset_path / path(filename);
+
+                    Mat1b img;
+                    if (!GetBinaryImage(filename_path, img)) {
+                        ob.Cwarning("Unable to open '" + filename + "', skipped");
+                        filenames[file].second = false;
+                        continue;
+                    }
+
+                    for (unsigned i = 0; i < algorithms.size(); ++i) {
+                        ChainCodeAlg *algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(algorithms[i].test_name);
+                        algorithm->img_ = img;
+
+                        try {
+                            algorithm->perf_.start();
+                            algorithm->PerformChainCode();
+                            algorithm->perf_.stop();
+                        }
+                        catch (const exception& e) {
+                            algorithm->FreeChainCodeData();
+                            ob.Cerror("Something wrong with " + algorithms[i].test_name + ": " + e.what()); // You should check your algorithms' implementation before performing BACCA tests  
+                        }
+
+                        if (algorithm->perf_.last() < min_res(file, i)) {
+                            min_res(file, i) = algorithm->perf_.last();
+                        }
+
+                        algorithm->FreeChainCodeData();
+                    }
+                }
+                ob.StopRepeatedBox(false);
+            }
+
+            for (unsigned file = 0; file < filenames_size; ++file) {
+                if (filenames[file].second) {
+                    for (int i = 0; i < min_res.cols; ++i) {
+                        total_res(t, i) += min_res(file, i);
+                    }
+                }
+            }
+        }
+
+        // Algorithms are left with their default number of threads
+        for (const auto& algo_struct : algorithms) {
+            ChainCodeAlgMapSingleton::GetChainCodeAlg(algo_struct.test_name)->SetThreadsNumber(DefaultThreadsNumber());
+        }
+
+        ofstream scalability_os(scalability_os_path.string());
+        if (!scalability_os.is_open()) {
+            ob.Cwarning("Unable to open '" + scalability_os_path.string() + "', skipped", dataset_name);
+            continue;
+        }
+
+        // Two columns for every algorithm: total time [ms] and speedup
+        scalability_os << "#Threads";
+        for (const auto& algo_struct : algorithms) {
+            scalability_os << '\t' << algo_struct.display_name << "_time" << '\t' << algo_struct.display_name << "_speedup";
+        }
+        scalability_os << '\n';
+
+        for (int t = 0; t < total_res.rows; ++t) {
+            scalability_os << threads[t];
+            for (int i = 0; i < total_res.cols; ++i) {
+                scalability_os << '\t' << std::fixed << std::setprecision(8) << total_res(t, i);
+                scalability_os << '\t' << std::fixed << std::setprecision(2) << total_res(0, i) / total_res(t, i);
+            }
+            scalability_os << '\n';
+        }
+        scalability_os.close();
+
+        { // GNUPLOT SCRIPT
+            path script_os_path = current_output_path / path(dataset_name + cfg_.gnuplot_script_extension);
+
+            ofstream script_os(script_os_path.string());
+            if (!script_os.is_open()) {
+                ob.Cwarning("Unable to create " + script_os_path.string());
+            }
+
+            script_os << "# This is a gnuplot (http://www.gnuplot.info/) script!" << '\n';
+            script_os << "# comment fifth line, open gnuplot's teminal, move to script's path and launch 'load " << dataset_name + cfg_.gnuplot_script_extension << "' if you want to run it" << '\n' << '\n';
+
+            script_os << "reset" << '\n';
+            script_os << "cd '" << current_output_path.string() << "\'" << '\n';
+            script_os << "set grid" << '\n' << '\n';
+
+            script_os << "# " << dataset_name << "(COLORS)" << '\n';
+            script_os << "set output \"" + output_graph + "\"" << '\n';
+            script_os << "set title " << GetGnuplotTitle(cfg_) << '\n' << '\n';
+            script_os << "set terminal " << kTerminal << " enhanced color font ',15'" << '\n' << '\n';
+
+            script_os << "# Axes labels" << '\n';
+            script_os << "set xlabel \"Threads\"" << '\n';
+            script_os << "set ylabel \"Speedup\"" << '\n';
+            script_os << "set logscale x 2" << '\n' << '\n';
+
+            script_os << "# Legend" << '\n';
+            script_os << "set key left top" << '\n' << '\n';
+
+            script_os << "# Plot" << '\n';
+            script_os << "plot x title \"Ideal\" with lines dashtype 2";
+            for (unsigned i = 0; i < algorithms.size(); ++i) {
+                string algo_name_double_escaped = DoubleEscapeUnderscore(string(algorithms[i].display_name));
+                script_os << ", \\" << '\n' << "'" << output_scalability_results << "' using 1:" << 3 + 2 * i << " title \"" << algo_name_double_escaped << "\" with linespoints";
+            }
+            script_os << '\n' << '\n';
+
+            script_os << "exit gnuplot" << '\n';
+
+            script_os.close();
+        } // GNUPLOT SCRIPT
+
+        if (0 != std::system(("gnuplot \"" + (current_output_path / path(dataset_name + cfg_.gnuplot_script_extension)).string() + "\" 2> gnuplot_errors.txt").c_str())) {
+            ob.Cwarning("Unable to run gnuplot script");
+        }
+        ob.CloseBox();
+    } // END DATASET FOR
+}
+
+// Images and megapixels per second of every algorithm on every dataset, when the images of the
+// dataset are processed as a batch over each number of threads in the 'throughput_threads' list.
+// Every thread works with its own instance of the algorithm (see PerformChainCodeBatch()).
+void BACCATests::ThroughputTest()
+{
+    OutputBox ob("Throughput Test");
+
+    const auto& threads = cfg_.throughput_threads;
+    const auto& algorithms = cfg_.thin_average_algorithms;
+
+    for (unsigned d = 0; d < cfg_.throughput_datasets.size(); ++d) { // For every dataset in the throughput list
+
+        String dataset_name(cfg_.throughput_datasets[d]),
+            output_throughput_results = dataset_name + "_throughput.txt";
+
+        path dataset_path(cfg_.input_path / path(dataset_name)),
+            is_path = dataset_path / path(cfg_.input_txt), // files.txt path
+            current_output_path(cfg_.output_path / path(cfg_.throughput_folder)),
+            throughput_os_path = current_output_path / path(output_throughput_results);
+
+        if (!create_directories(current_output_path)) {
+            ob.Cwarning("Unable to find/create the output path '" + current_output_path.string() + "', skipped", dataset_name);
+            continue;
+        }
+
+        vector<pair<string, bool>> filenames;  // first: filename, second: state of filename (find or not)
+        if (!LoadFileList(filenames, is_path)) {
+            ob.Cwarning("Unable to open '" + is_path.string() + "', skipped", dataset_name);
+            continue;
+        }
+
+        // The whole dataset is loaded in advance, so that only the algorithms are measured
+        vector<Mat1b> imgs;
+        double megapixels = 0;
+        for (const auto& file : filenames) {
+            Mat1b img;
+            if (!GetBinaryImage(dataset_path / path(file.first), img)) {
+                ob.Cwarning("Unable to open '" + file.first + "', skipped");
+                continue;
+            }
+            megapixels += static_cast<double>(img.rows) * img.cols / 1e6;
+            imgs.push_back(img);
+        }
+        if (imgs.empty()) {
+            ob.Cwarning("There are no valid images, skipped", dataset_name);
+            continue;
+        }
+
+        // Rows represent numbers of threads, columns represent algorithms: minimum time [ms] of the batch
+        Mat1d min_res(static_cast<int>(threads.size()), static_cast<int>(algorithms.size()), numeric_limits<double>::max());
+
+        ob.StartRepeatedBox(dataset_name, static_cast<unsigned>(threads.size()), cfg_.throughput_tests_number);
+        for (unsigned test = 0; test < cfg_.throughput_tests_number; ++test) {
+            for (unsigned t = 0; t < threads.size(); ++t) {
+                ob.UpdateRepeatedBox(t);
+
+                for (unsigned i = 0; i < algorithms.size(); ++i) {
+                    PerformanceEvaluator perf;
+                    try {
+                        // The results are released once the batch has been measured
+                        perf.start();
+                        vector<BatchResult> results = PerformChainCodeBatch(algorithms[i].test_name, imgs, threads[t]);
+                        perf.stop();
+                    }
+                    catch (const exception& e) {
+                        ob.Cerror("Something wrong with " + algorithms[i].test_name + ": " + e.what()); // You should check your algorithms' implementation before performing BACCA tests  
+                    }
+
+                    if (perf.last() < min_res(t, i)) {
+                        min_res(t, i) = perf.last();
+                    }
+                }
+            }
+            ob.StopRepeatedBox(false);
+        }
+        ob.CloseBox();
+
+        ofstream throughput_os(throughput_os_path.string());
+        if (!throughput_os.is_open()) {
+            ob.Cwarning("Unable to open '" + throughput_os_path.string() + "', skipped", dataset_name);
+            continue;
+        }
+
+        // Two columns for every algorithm: images per second and megapixels per second
+        throughput_os << "#Threads";
+        for (const auto& algo_struct : algorithms) {
+            throughput_os << '\t' << algo_struct.display_name << "_img/s" << '\t' << algo_struct.display_name << "_MP/s";
+        }
+        throughput_os << '\n';
+
+        for (int t = 0; t < min_res.rows; ++t) {
+            throughput_os << threads[t];
+            for (int i = 0; i < min_res.cols; ++i) {
+                const double seconds = min_res(t, i) / 1000.;
+                throughput_os << '\t' << std::fixed << std::setprecision(2) << imgs.size() / seconds;
+                throughput_os << '\t' << std::fixed << std::setprecision(2) << megapixels / seconds;
+            }
+            throughput_os << '\n';
+        }
+        throughput_os.close();
+    } // END DATASET FOR
+}
+
+// Synthetic image with vertical stripes, 2 pixels wide and 3 pixels apart, which keep two chains
+// open on every row. The gaps are dotted with small 1x2 objects, so that chains are continuously
+// opened and closed among the ones of the stripes.
+Mat1b OpenChainsImage(int w, int h, mt19937& generator)
+{
+    Mat1b img(h, w, static_cast<uchar>(0));
+    bernoulli_distribution dot(0.25);
+    for (int r = 0; r < h; ++r) {
+        uchar* const row = img.ptr<uchar>(r);
+        for (int c = 0; c < w; c += 5) {
+            row[c] = 1;
+            if (c + 1 < w) {
+                row[c + 1] = 1;
+            }
+        }
+    }
+    for (int r = 0; r + 1 < h; r += 3) {
+        for (int c = 3; c < w; c += 5) {
+            if (dot(generator)) {
+                img(r, c) = 1;
+                img(r + 1, c) = 1;
+            }
+        }
+    }
+    return img;
+}
+
+// Execution time of every algorithm on synthetic images of increasing width, and thus with an
+// increasing number of simultaneously open chains.
+void BACCATests::OpenChainsTest()
+{
+    OutputBox ob("Open Chains Test");
+
+    const int height = 1000;
+    const vector<int> widths = { 500, 1000, 2000, 4000, 8000, 16000 };
+
+    String output_open_chains_results = "open_chains.txt",
+        output_graph = "open_chains" + kTerminalExtension;
+
+    path current_output_path(cfg_.output_path / path(cfg_.open_chains_folder)),
+        open_chains_os_path = current_output_path / path(output_open_chains_results);
+
+    if (!create_directories(current_output_path)) {
+        ob.Cwarning("Unable to find/create the output path '" + current_output_path.string() + "', 'open chains test' skipped");
+        ob.CloseBox();
+        return;
+    }
+
+    // Rows represent image widths, columns represent algorithms
+    Mat1d min_res(static_cast<int>(widths.size()), static_cast<int>(cfg_.thin_average_algorithms.size()), numeric_limits<double>::max());
+
+    ob.StartRepeatedBox("synthetic", static_cast<unsigned>(widths.size()), cfg_.open_chains_tests_number);
+
+    for (unsigned test = 0; test < cfg_.open_chains_tests_number; ++test) {
+        mt19937 generator(0);
+        for (unsigned i = 0; i < widths.size(); ++i) {
+            ob.UpdateRepeatedBox(i);
+
+            Mat1b img = OpenChainsImage(widths[i], height, generator);
+
+            for (unsigned j = 0; j < cfg_.thin_average_algorithms.size(); ++j) {
+                ChainCodeAlg *algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(cfg_.thin_average_algorithms[j].test_name);
+                algorithm->img_ = img;
+
+                try {
+                    algorithm->perf_.start();
+                    algorithm->PerformChainCode();
+                    algorithm->perf_.stop();
+                }
+                catch (const exception& e) {
+                    algorithm->FreeChainCodeData();
+                    ob.Cerror("Something wrong with " + cfg_.thin_average_algorithms[j].test_name + ": " + e.what()); // You should check your algorithms' implementation before performing BACCA tests  
+                }
+
+                if (algorithm->perf_.last() < min_res(i, j)) {
+                    min_res(i, j) = algorithm->perf_.last();
+                }
+
+                algorithm->FreeChainCodeData();
+            }
+        }
+        ob.StopRepeatedBox(false);
+    }
+
+    ofstream open_chains_os(open_chains_os_path.string());
+    if (!open_chains_os.is_open()) {
+        ob.Cwarning("Unable to open '" + open_chains_os_path.string() + "', 'open chains test' skipped");
+        ob.CloseBox();
+        return;
+    }
+
+    // Stripes alone keep two chains open each
+    open_chains_os << "#Open chains";
+    for (const auto& algo_struct : cfg_.thin_average_algorithms) {
+        open_chains_os << '\t' << algo_struct.display_name;
+    }
+    open_chains_os << '\n';
+
+    for (int i = 0; i < min_res.rows; ++i) {
+        open_chains_os << 2 * ((widths[i] + 4) / 5);
+        for (int j = 0; j < min_res.cols; ++j) {
+            open_chains_os << '\t' << std::fixed << std::setprecision(8) << min_res(i, j);
+        }
+        open_chains_os << '\n';
+    }
+    open_chains_os.close();
+
+    { // GNUPLOT SCRIPT
+        path script_os_path = current_output_path / path("open_chains" + cfg_.gnuplot_script_extension);
+
+        ofstream script_os(script_os_path.string());
+        if (!script_os.is_open()) {
+            ob.Cwarning("Unable to create " + script_os_path.string());
+        }
+
+        script_os << "# This is a gnuplot (http://www.gnuplot.info/) script!" << '\n';
+        script_os << "# comment fifth line, open gnuplot's teminal, move to script's path and launch 'load open_chains" << cfg_.gnuplot_script_extension << "' if you want to run it" << '\n' << '\n';
+
+        script_os << "reset" << '\n';
+        script_os << "cd '" << current_output_path.string() << "\'" << '\n';
+        script_os << "set grid" << '\n' << '\n';
+
+        script_os << "set output \"" + output_graph + "\"" << '\n';
+        script_os << "set title " << GetGnuplotTitle(cfg_) << '\n' << '\n';
+        script_os << "set terminal " << kTerminal << " enhanced color font ',15'" << '\n' << '\n';
+
+        script_os << "# Axes labels" << '\n';
+        script_os << "set xlabel \"Open chains\"" << '\n';
+        script_os << "set ylabel \"Execution Time [ms]\"" << '\n';
+        script_os << "set logscale xy 2" << '\n' << '\n';
+
+        script_os << "# Legend" << '\n';
+        script_os << "set key left top" << '\n' << '\n';
+
+        script_os << "# Plot" << '\n';
+        script_os << "plot \\" << '\n';
+        for (unsigned j = 0; j < cfg_.thin_average_algorithms.size(); ++j) {
+            string algo_name_double_escaped = DoubleEscapeUnderscore(string(cfg_.thin_average_algorithms[j].display_name));
+            script_os << "'" << output_open_chains_results << "' using 1:" << j + 2 << " title \"" << algo_name_double_escaped << "\" with linespoints";
+            script_os << (j + 1 < cfg_.thin_average_algorithms.size() ? ", \\" : "") << '\n';
+        }
+        script_os << '\n';
+
+        script_os << "exit gnuplot" << '\n';
+
+        script_os.close();
+    } // GNUPLOT SCRIPT
+
+    if (0 != std::system(("gnuplot \"" + (current_output_path / path("open_chains" + cfg_.gnuplot_script_extension)).string() + "\" 2> gnuplot_errors.txt").c_str())) {
+        ob.Cwarning("Unable to run gnuplot script");
+    }
+    ob.CloseBox();
+}
+
+// Average number of heap allocations performed by every algorithm for a single image, conversion
+// to chain code included. Every dataset is a column of the output table.
+void BACCATests::AllocationsTest()
+{
+    OutputBox ob("Allocations Test");
+
+    const auto& algorithms = cfg_.thin_average_algorithms;
+
+    path current_output_path(cfg_.output_path / path(cfg_.allocations_folder)),
+        allocations_os_path = current_output_path / path(cfg_.allocations_file);
+
+    if (!create_directories(current_output_path)) {
+        ob.Cwarning("Unable to find/create the output path '" + current_output_path.string() + "', 'allocations test' skipped");
+        ob.CloseBox();
+        return;
+    }
+
+    // Rows represent algorithms, columns represent datasets
+    Mat1d allocations(static_cast<int>(algorithms.size()), static_cast<int>(cfg_.allocations_datasets.size()), 0.0);
+
+    for (unsigned d = 0; d < cfg_.allocations_datasets.size(); ++d) { // For every dataset in the allocations list
+        String dataset_name(cfg_.allocations_datasets[d]);
+
+        path dataset_path(cfg_.input_path / path(dataset_name)),
+            is_path = dataset_path / path(cfg_.input_txt); // files.txt path
+
+        vector<pair<string, bool>> filenames;  // first: filename, second: state of filename (find or not)
+        if (!LoadFileList(filenames, is_path)) {
+            ob.Cwarning("Unable to open '" + is_path.string() + "', skipped", dataset_name);
+            continue;
+        }
+
+        unsigned filenames_size = static_cast<unsigned>(filenames.size());
+        unsigned tot_test = 0;
+
+        ob.StartUnitaryBox(dataset_name, filenames_size);
+
+        for (unsigned file = 0; file < filenames_size; ++file) {
+            ob.UpdateUnitaryBox(file);
+
+            string filename = filenames[file].first;
+            path filename_path = dataset_path / path(filename);
+
+            Mat1b img;
+            if (!GetBinaryImage(filename_path, img)) {
+                ob.Cwarning("Unable to open '" + filename + "'");
+                continue;
+            }
+
+            ++tot_test;
+
+            for (unsigned i = 0; i < algorithms.size(); ++i) {
+                ChainCodeAlg *algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(algorithms[i].test_name);
+                algorithm->img_ = img;
+
+                const uint64_t allocations_before = AllocationsNumber();
+                try {
+                    algorithm->PerformChainCode();
+                }
+                catch (const exception& e) {
+                    algorithm->FreeChainCodeData();
+                    ob.Cerror("Something wrong with " + algorithms[i].test_name + ": " + e.what()); // You should check your algorithms' implementation before performing BACCA tests  
+                }
+                allocations(i, d) += static_cast<double>(AllocationsNumber() - allocations_before);
+
+                algorithm->FreeChainCodeData();
+            }
+        }
+        ob.StopUnitaryBox();
+
+        if (tot_test > 0) {
+            for (int i = 0; i < allocations.rows; ++i) {
+                allocations(i, d) /= tot_test;
+            }
+        }
+    }
+
+    ofstream allocations_os(allocations_os_path.string());
+    if (!allocations_os.is_open()) {
+        ob.Cwarning("Unable to open '" + allocations_os_path.string() + "', 'allocations test' skipped");
+        ob.CloseBox();
+        return;
+    }
+
+    allocations_os << "#Average number of heap allocations per image" << '\n';
+    allocations_os << "Algorithm";
+    for (const auto& dataset_name : cfg_.allocations_datasets) {
+        allocations_os << '\t' << dataset_name;
+    }
+    allocations_os << '\n';
+
+    for (int i = 0; i < allocations.rows; ++i) {
+        allocations_os << algorithms[i].display_name;
+        for (int d = 0; d < allocations.cols; ++d) {
+            allocations_os << '\t' << std::fixed << std::setprecision(0) << allocations(i, d);
+        }
+        allocations_os << '\n';
+    }
+    allocations_os.close();
+
+    ob.CloseBox();
+}
+
 void BACCATests::LatexGenerator()
 {
     OutputBox ob("Generation of Latex file/s");
@@ -13,77 +13,97 @@
 
 #include "chain_code.h"
 
-using namespace std;
-
-
-ChainCode::ChainCode(const std::vector<std::vector<cv::Point>>& contours, bool contrary) {
-    for (const std::vector<cv::Point>& contour : contours) {
-
-        // Find top-left value
-        int top = 0;
-        cv::Point max = contour.front();
-        for (unsigned int i = 1; i < contour.size(); i++) {
-            if (contour[i].y < max.y || (contour[i].y == max.y && contour[i].x < max.x)) {
-                max = contour[i];
-                top = i;
-            }
-        }
+#include "parallel.h"
 
-        Chain chain(max.y, max.x);
-        cv::Point prev = max;
+using namespace std;
 
-        if (contour.size() > 1) {
+constexpr unsigned RCNode::kNone;
+constexpr unsigned RCNodeTree::kRoot;
+constexpr size_t ChainArena::kSlabWords;
 
-            if (contrary) {
-                for (int i = top - 1 + static_cast<int>(contour.size()); i >= top; i--) { // OpenCV order is reversed
 
-                    cv::Point cur = contour[i % contour.size()];
-                    cv::Point diff = cur - prev;
+namespace {
 
-                    int link;
-                    if (diff.x == -1) {
-                        link = diff.y + 4;
-                    }
-                    else if (diff.x == 0) {
-                        link = diff.y * 2 + 4;
-                    }
-                    else if (diff.x == 1) {
-                        link = (8 - diff.y) % 8;
-                    }
+// Position of the top-left point of contour, where its chain starts
+unsigned TopLeftPoint(const std::vector<cv::Point>& contour) {
+    unsigned top = 0;
+    for (unsigned int i = 1; i < contour.size(); i++) {
+        if (contour[i].y < contour[top].y || (contour[i].y == contour[top].y && contour[i].x < contour[top].x)) {
+            top = i;
+        }
+    }
+    return top;
+}
 
-                    chain.push_back(link);
+// Calls f with the value of every link of contour, starting from the point at top. The points of
+// cv::findContours are in the reversed order, so they are followed backwards when contrary is set.
+template <typename F>
+void ForEachLink(const std::vector<cv::Point>& contour, unsigned top, bool contrary, F f) {
+    if (contour.size() < 2) {
+        return;
+    }
 
-                    prev = cur;
+    const int n = static_cast<int>(contour.size());
+    const int step = contrary ? n - 1 : 1;
+    cv::Point prev = contour[top];
+    for (int k = 1, i = top; k <= n; k++) {
 
-                }
-            }
-            else {
-                for (unsigned int i = top + 1; i <= top + contour.size(); i++) {
+        i = (i + step) % n;
+        cv::Point cur = contour[i];
+        cv::Point diff = cur - prev;
 
-                    cv::Point cur = contour[i % contour.size()];
-                    cv::Point diff = cur - prev;
+        int link;
+        if (diff.x == -1) {
+            link = diff.y + 4;
+        }
+        else if (diff.x == 0) {
+            link = diff.y * 2 + 4;
+        }
+        else {
+            link = (8 - diff.y) % 8;
+        }
 
-                    int link;
-                    if (diff.x == -1) {
-                        link = diff.y + 4;
-                    }
-                    else if (diff.x == 0) {
-                        link = diff.y * 2 + 4;
-                    }
-                    else if (diff.x == 1) {
-                        link = (8 - diff.y) % 8;
-                    }
+        f(link);
 
-                    chain.push_back(link);
+        prev = cur;
+    }
+}
 
-                    prev = cur;
+}
 
-                }
-            }
+ChainCode::ChainCode(const std::vector<std::vector<cv::Point>>& contours, bool contrary) {
+    for (const std::vector<cv::Point>& contour : contours) {
+        const unsigned top = TopLeftPoint(contour);
+        Chain chain(contour[top].y, contour[top].x);
+        ForEachLink(contour, top, contrary, [&](int link) { chain.push_back(link); });
+        chains.push_back(chain);
+    }
+}
 
-        }
+void FlatChainCode::Assign(const std::vector<std::vector<cv::Point>>& cv_contours, bool contrary) {
+    Clear();
+    for (const std::vector<cv::Point>& contour : cv_contours) {
+        const unsigned top = TopLeftPoint(contour);
+        const size_t n_values = contour.size() > 1 ? contour.size() : 0;
+        const size_t first_word = values.size();
+        contours.push_back({ static_cast<unsigned>(contour[top].y), static_cast<unsigned>(contour[top].x), first_word, n_values });
+        values.resize(first_word + (n_values + 7) / 8, 0);
+
+        uint32_t* words = values.data() + first_word;
+        size_t index = 0;
+        ForEachLink(contour, top, contrary, [&](int link) {
+            words[index / 8] |= static_cast<uint32_t>(link & 15) << ((index & 7) * 4);
+            index++;
+        });
+    }
+}
 
-        chains.push_back(chain);
+void FlatChainCode::Assign(const ChainCode& chcode) {
+    Clear();
+    contours.reserve(chcode.chains.size());
+    for (const ChainCode::Chain& chain : chcode) {
+        contours.push_back({ chain.row, chain.col, values.size(), chain.value_count });
+        values.insert(values.end(), chain.internal_values.begin(), chain.internal_values.end());
     }
 }
 
@@ -109,92 +129,192 @@ bool ChainCode::Chain::operator<(const Chain& rhs) const {
     }
 }
 
-void ChainCode::Chain::AddRightChain(const RCCode::Chain& chain) {
-
-    for (unsigned i = 0; i < chain.value_count; i++) {
-        uint8_t val = chain.get_value(i);
-        uint8_t new_val;
-        if (val == 0) {
-            new_val = 0;
-        }
-        else {
-            new_val = 8 - val;
+// Tables converting 4 links of RCChain, one byte, to the 4 values of a Chain, 16 bits. Links of
+// right chains are mapped from 2 to 3 bits (0 stays 0, v becomes 8 - v), links of left chains are
+// also reversed (v becomes 4 - v), since left chains are appended from their last link.
+struct LinkTables {
+    uint16_t right[256];
+    uint16_t left[256];
+
+    LinkTables() {
+        for (unsigned byte = 0; byte < 256; byte++) {
+            right[byte] = 0;
+            left[byte] = 0;
+            for (unsigned i = 0; i < 4; i++) {
+                const unsigned val = (byte >> (i * 2)) & 3;
+                right[byte] |= (val == 0 ? 0 : 8 - val) << (i * 4);
+                left[byte] |= (4 - val) << ((3 - i) * 4);
+            }
         }
-        push_back(new_val);
     }
+};
+
+static const LinkTables link_tables;
+
+// 16 links of a right chain, from the least significant bits
+static inline uint64_t RightValues(uint32_t links) {
+    return uint64_t(link_tables.right[links & 0xFF])
+        | (uint64_t(link_tables.right[(links >> 8) & 0xFF]) << 16)
+        | (uint64_t(link_tables.right[(links >> 16) & 0xFF]) << 32)
+        | (uint64_t(link_tables.right[links >> 24]) << 48);
+}
 
+// 16 links of a left chain, from the most significant bits
+static inline uint64_t LeftValues(uint32_t links) {
+    return uint64_t(link_tables.left[links >> 24])
+        | (uint64_t(link_tables.left[(links >> 16) & 0xFF]) << 16)
+        | (uint64_t(link_tables.left[(links >> 8) & 0xFF]) << 32)
+        | (uint64_t(link_tables.left[links & 0xFF]) << 48);
 }
 
-void ChainCode::Chain::AddLeftChain(const RCCode::Chain& chain) {
+// Appends the first count (up to 16) values of group to the value_count ones in words, which
+// are n_words. The values of a group span up to three words, according to the position of the first one.
+static inline void AppendValues(uint32_t* words, size_t n_words, size_t& value_count, uint64_t group, unsigned count) {
+    if (count < 16) {
+        group &= (uint64_t(1) << (count * 4)) - 1;
+    }
+
+    const size_t index = value_count / 8;
+    const unsigned shift = (value_count & 7) * 4;
 
-    for (int i = static_cast<int>(chain.value_count) - 1; i >= 0; i--) {
-        uint8_t val = 4 - chain.get_value(i);
-        push_back(val);
+    words[index] |= static_cast<uint32_t>(group << shift);
+    group >>= 32 - shift;
+    if (index + 1 < n_words) {
+        words[index + 1] |= static_cast<uint32_t>(group);
     }
+    if (index + 2 < n_words) {
+        words[index + 2] |= static_cast<uint32_t>(group >> 32);
+    }
+
+    value_count += count;
 }
 
-void ChainCode::AddChain(const RCCode& rccode, vector<int>& used_elems, unsigned pos) {
+// Appends the values of a right chain, 16 links at a time
+static inline void AppendRightChain(const RCChain& chain, uint32_t* words, size_t n_words, size_t& value_count) {
 
-    int chain_pos = static_cast<int>(chains.size());
+    const unsigned n = chain.value_count;
+    const uint32_t* links = chain.data();
+    for (unsigned i = 0; i < n / 16; i++) {
+        AppendValues(words, n_words, value_count, RightValues(links[i]), 16);
+    }
+    if (n % 16 != 0) {
+        AppendValues(words, n_words, value_count, RightValues(links[n / 16]), n % 16);
+    }
+}
 
-    Chain new_chain(rccode[pos].row, rccode[pos].col);
+// Appends the values of a left chain from its last link: the last word comes first, with its
+// values moved to the least significant bits
+static inline void AppendLeftChain(const RCChain& chain, uint32_t* words, size_t n_words, size_t& value_count) {
 
-    new_chain.AddRightChain(rccode[pos].right);
+    const unsigned n = chain.value_count;
+    const uint32_t* links = chain.data();
+    unsigned i = n / 16;
+    if (n % 16 != 0) {
+        AppendValues(words, n_words, value_count, LeftValues(links[i]) >> ((16 - n % 16) * 4), n % 16);
+    }
+    while (i > 0) {
+        i--;
+        AppendValues(words, n_words, value_count, LeftValues(links[i]), 16);
+    }
+}
 
-    used_elems[pos] = chain_pos;
+void ChainCode::Chain::AddRightChain(const RCChain& chain) {
+    if (chain.value_count == 0) {
+        return;
+    }
+    internal_values.resize((value_count + chain.value_count + 7) / 8, 0);
+    AppendRightChain(chain, internal_values.data(), internal_values.size(), value_count);
+}
 
-    while (true) {
+void ChainCode::Chain::AddLeftChain(const RCChain& chain) {
+    if (chain.value_count == 0) {
+        return;
+    }
+    internal_values.resize((value_count + chain.value_count + 7) / 8, 0);
+    AppendLeftChain(chain, internal_values.data(), internal_values.size(), value_count);
+}
 
-        pos = rccode[pos].next;
-        new_chain.AddLeftChain(rccode[pos].left);
+ChainCode FlatChainCode::ToChainCode() const {
+    ChainCode chcode;
+    chcode.chains.resize(contours.size());
+    for (size_t i = 0; i < contours.size(); i++) {
+        ChainCode::Chain& chain = chcode.chains[i];
+        chain.row = contours[i].row;
+        chain.col = contours[i].col;
+        chain.value_count = contours[i].value_count;
+        chain.internal_values.assign(Words(i), Words(i) + (contours[i].value_count + 7) / 8);
+    }
+    return chcode;
+}
 
-        if (used_elems[pos] != -1) {
-            break;
-        }
+template <typename Topology>
+void BuildChain(const BasicRCCode<Topology>& rccode, unsigned head, size_t n_values, ChainCode::Chain& chain) {
 
-        new_chain.AddRightChain(rccode[pos].right);
+    chain.row = rccode.Row(head);
+    chain.col = rccode.Col(head);
+    chain.internal_values.reserve((n_values + 7) / 8);
 
-        used_elems[pos] = chain_pos;
+    chain.AddRightChain(rccode.Right(head));
+    for (unsigned pos = rccode.Next(head); pos != head; pos = rccode.Next(pos)) {
+        chain.AddLeftChain(rccode.Left(pos));
+        chain.AddRightChain(rccode.Right(pos));
     }
+    chain.AddLeftChain(rccode.Left(head));
+}
+
+template <typename Topology>
+void ChainCode::AddChain(const BasicRCCode<Topology>& rccode, vector<int>& used_elems, unsigned pos) {
+
+    int chain_pos = static_cast<int>(chains.size());
 
-    chains.push_back(new_chain);
+    // The values of the contour are counted first, to be allocated at once
+    size_t n_values = 0;
+    unsigned elem = pos;
+    do {
+        n_values += rccode.Left(elem).value_count + rccode.Right(elem).value_count;
+        used_elems[elem] = chain_pos;
+        elem = rccode.Next(elem);
+    } while (elem != pos);
+
+    chains.emplace_back();
+    BuildChain(rccode, pos, n_values, chains.back());
 }
 
 
 void UpdateHierarchyRec(vector<cv::Vec4i>& hierarchy,
-    const RCCode& rccode, const vector<unique_ptr<RCNode>>& node_vec,
-    const vector<int>& used_elems) {
+    const RCNodeTree& tree, unsigned parent, const vector<int>& used_elems) {
 
-    for (auto it = node_vec.cbegin(); it != node_vec.cend(); ++it) {
-        auto node = it->get();
+    // Only nodes never merged are left in the lists of children, and they are
+    // listed by the node standing for their region, that is their actual parent
+    const int parent_pos = (parent == RCNodeTree::kRoot) ? -1 : used_elems[tree[parent].elem_index];
 
-        RCNode* parent = node->parent;
+    for (unsigned node = tree[parent].first_child; node != RCNode::kNone; node = tree[node].next_sibling) {
+        const RCNode& n = tree[node];
 
-        int chain_pos = used_elems[node->elem_index];
+        int chain_pos = used_elems[n.elem_index];
 
         // next sibling
-        hierarchy[chain_pos][0] = (it + 1 == node_vec.cend()) ? -1 : used_elems[(it + 1)->get()->elem_index];
+        hierarchy[chain_pos][0] = (n.next_sibling == RCNode::kNone) ? -1 : used_elems[tree[n.next_sibling].elem_index];
 
         // prev sibling
-        hierarchy[chain_pos][1] = (it == node_vec.cbegin()) ? -1 : used_elems[(it - 1)->get()->elem_index];
+        hierarchy[chain_pos][1] = (n.prev_sibling == RCNode::kNone) ? -1 : used_elems[tree[n.prev_sibling].elem_index];
 
         // first child
-        hierarchy[chain_pos][2] = node->children.size() > 0 ? used_elems[node->children[0]->elem_index] : -1;
+        hierarchy[chain_pos][2] = (n.first_child == RCNode::kNone) ? -1 : used_elems[tree[n.first_child].elem_index];
 
         // parent
-        hierarchy[chain_pos][3] = (parent->elem_index == -1) ? -1 : used_elems[parent->elem_index];
+        hierarchy[chain_pos][3] = parent_pos;
 
-        if (node->children.size() > 0) {
-            UpdateHierarchyRec(hierarchy, rccode, node->children, used_elems);
+        if (n.first_child != RCNode::kNone) {
+            UpdateHierarchyRec(hierarchy, tree, node, used_elems);
         }
     }
 
 }
 
 
-void RCCodeToChainCodeInternal(const RCCode& rccode, ChainCode& chcode, vector<int>& used_elems) {
-
-    const RCNode* root = rccode.root.get();
+template <typename Topology>
+void RCCodeToChainCodeInternal(const BasicRCCode<Topology>& rccode, ChainCode& chcode, vector<int>& used_elems) {
 
     for (unsigned i = 0; i < rccode.Size(); i++) {
         if (used_elems[i] == -1) {
@@ -210,13 +330,458 @@ void RCCodeToChainCode(const RCCode& rccode, ChainCode& chcode) {
     RCCodeToChainCodeInternal(rccode, chcode, used_elems);
 }
 
-void RCCodeToChainCode(const RCCode& rccode, ChainCode& chcode, vector<cv::Vec4i>& hierarchy) {
+void RCCodeToChainCode(const RCCodeTopology& rccode, ChainCode& chcode, vector<cv::Vec4i>& hierarchy) {
     vector<int> used_elems(rccode.Size(), -1);
     //used_elems.resize(rccode.Size(), false);
     RCCodeToChainCodeInternal(rccode, chcode, used_elems);
 
     hierarchy = vector<cv::Vec4i>(chcode.chains.size());
-    UpdateHierarchyRec(hierarchy, rccode, rccode.root->children, used_elems);
+    UpdateHierarchyRec(hierarchy, rccode.tree, RCNodeTree::kRoot, used_elems);
+}
+
+// Contours are converted by threads in blocks of this many, taken one after the other
+constexpr unsigned kContoursPerTask = 256;
+
+// Calls body(k) for every contour k in [0, n_contours), over n_threads threads
+template <typename Body>
+void ForEachContour(size_t n_contours, unsigned n_threads, const Body& body) {
+    const unsigned n = static_cast<unsigned>(n_contours);
+    const unsigned n_tasks = (n + kContoursPerTask - 1) / kContoursPerTask;
+    ParallelForDynamic(n_tasks, n_threads, [&](unsigned /*thread*/, unsigned task) {
+        const unsigned end = min(n, (task + 1) * kContoursPerTask);
+        for (unsigned k = task * kContoursPerTask; k < end; k++) {
+            body(k);
+        }
+    });
+}
+
+// Finds the first max point of every contour not yet used, and its number of values, following
+// only the links between max points. Every elem is marked with the position of its contour.
+template <typename Topology>
+void FindContourHeads(const BasicRCCode<Topology>& rccode, vector<int>& used_elems, size_t first_chain,
+    vector<unsigned>& heads, vector<size_t>& n_values) {
+
+    for (unsigned i = 0; i < rccode.Size(); i++) {
+        if (used_elems[i] != -1) {
+            continue;
+        }
+        const int chain_pos = static_cast<int>(first_chain + heads.size());
+        size_t count = 0;
+        unsigned elem = i;
+        do {
+            count += rccode.Left(elem).value_count + rccode.Right(elem).value_count;
+            used_elems[elem] = chain_pos;
+            elem = rccode.Next(elem);
+        } while (elem != i);
+        heads.push_back(i);
+        n_values.push_back(count);
+    }
+}
+
+template <typename Topology>
+void RCCodeToChainCodeParallel(const BasicRCCode<Topology>& rccode, ChainCode& chcode, vector<int>& used_elems, unsigned n_threads) {
+
+    const size_t first_chain = chcode.chains.size();
+    vector<unsigned> heads;
+    vector<size_t> n_values;
+    FindContourHeads(rccode, used_elems, first_chain, heads, n_values);
+
+    // Then every contour is built in its own slot
+    chcode.chains.resize(first_chain + heads.size());
+    ForEachContour(heads.size(), n_threads, [&](unsigned k) {
+        BuildChain(rccode, heads[k], n_values[k], chcode.chains[first_chain + k]);
+    });
+}
+
+void RCCodeToChainCode(const RCCode& rccode, ChainCode& chcode, unsigned n_threads) {
+    vector<int> used_elems(rccode.Size(), -1);
+    RCCodeToChainCodeParallel(rccode, chcode, used_elems, n_threads);
+}
+
+void RCCodeToChainCode(const RCCodeTopology& rccode, ChainCode& chcode, vector<cv::Vec4i>& hierarchy, unsigned n_threads) {
+    vector<int> used_elems(rccode.Size(), -1);
+    RCCodeToChainCodeParallel(rccode, chcode, used_elems, n_threads);
+
+    hierarchy = vector<cv::Vec4i>(chcode.chains.size());
+    UpdateHierarchyRec(hierarchy, rccode.tree, RCNodeTree::kRoot, used_elems);
+}
+
+
+// Appends the holes found in the region of parent, at any depth, to nodes
+void CollectHoles(const RCNodeTree& tree, unsigned parent, vector<unsigned>& nodes) {
+
+    for (unsigned node = tree[parent].first_child; node != RCNode::kNone; node = tree[node].next_sibling) {
+        if (tree[node].status == RCNode::Status::H) {
+            nodes.push_back(node);
+        }
+        if (tree[node].first_child != RCNode::kNone) {
+            CollectHoles(tree, node, nodes);
+        }
+    }
+}
+
+// Nodes of the contours kept by retrieval, other than ContourRetrieval::All
+vector<unsigned> SelectContours(const RCNodeTree& tree, ContourRetrieval retrieval) {
+
+    vector<unsigned> nodes;
+    if (retrieval == ContourRetrieval::External) {
+        for (unsigned node = tree[RCNodeTree::kRoot].first_child; node != RCNode::kNone; node = tree[node].next_sibling) {
+            nodes.push_back(node);
+        }
+    }
+    else {
+        CollectHoles(tree, RCNodeTree::kRoot, nodes);
+    }
+    return nodes;
+}
+
+// Hierarchy of n contours which are all siblings
+void SiblingsHierarchy(vector<cv::Vec4i>& hierarchy, size_t n_contours) {
+
+    const int n = static_cast<int>(n_contours);
+    hierarchy.assign(n_contours, cv::Vec4i(-1, -1, -1, -1));
+    for (int i = 0; i < n; ++i) {
+        hierarchy[i][0] = (i + 1 < n) ? i + 1 : -1;
+        hierarchy[i][1] = i - 1;
+    }
+}
+
+void RCCodeToChainCode(const RCCodeTopology& rccode, ChainCode& chcode, vector<cv::Vec4i>& hierarchy, ContourRetrieval retrieval) {
+
+    if (retrieval == ContourRetrieval::All) {
+        RCCodeToChainCode(rccode, chcode, hierarchy);
+        return;
+    }
+
+    const RCNodeTree& tree = rccode.tree;
+    const vector<unsigned> nodes = SelectContours(tree, retrieval);
+
+    // Every node points to the top-left max point of its contour, where the conversion of
+    // all the contours would have started as well
+    vector<int> used_elems(rccode.Size(), -1);
+    chcode.chains.reserve(chcode.chains.size() + nodes.size());
+    for (unsigned node : nodes) {
+        chcode.AddChain(rccode, used_elems, static_cast<unsigned>(tree[node].elem_index));
+    }
+
+    SiblingsHierarchy(hierarchy, nodes.size());
+}
+
+
+// Writes the values of the contour starting from the max point head to words, which are n_words
+// and cleared
+template <typename Topology>
+void FillContourWords(const BasicRCCode<Topology>& rccode, unsigned head, uint32_t* words, size_t n_words) {
+
+    size_t value_count = 0;
+    AppendRightChain(rccode.Right(head), words, n_words, value_count);
+    for (unsigned pos = rccode.Next(head); pos != head; pos = rccode.Next(pos)) {
+        AppendLeftChain(rccode.Left(pos), words, n_words, value_count);
+        AppendRightChain(rccode.Right(pos), words, n_words, value_count);
+    }
+    AppendLeftChain(rccode.Left(head), words, n_words, value_count);
+}
+
+// Appends the contour starting from the max point head, which has n_values values, to flat
+template <typename Topology>
+void AppendFlatContour(const BasicRCCode<Topology>& rccode, unsigned head, size_t n_values, FlatChainCode& flat) {
+
+    const size_t first_word = flat.values.size();
+    const size_t n_words = (n_values + 7) / 8;
+    flat.contours.push_back({ rccode.Row(head), rccode.Col(head), first_word, n_values });
+    flat.values.resize(first_word + n_words, 0);
+    FillContourWords(rccode, head, flat.values.data() + first_word, n_words);
+}
+
+// With more threads, the slots of all the contours are laid out before they are filled
+template <typename Topology>
+void BuildFlatChainCode(const BasicRCCode<Topology>& rccode, const vector<unsigned>& heads, const vector<size_t>& n_values,
+    FlatChainCode& flat, unsigned n_threads) {
+
+    flat.contours.resize(heads.size());
+    size_t n_words = 0;
+    for (size_t k = 0; k < heads.size(); k++) {
+        flat.contours[k] = { rccode.Row(heads[k]), rccode.Col(heads[k]), n_words, n_values[k] };
+        n_words += (n_values[k] + 7) / 8;
+    }
+    flat.values.resize(n_words, 0);
+
+    ForEachContour(heads.size(), n_threads, [&](unsigned k) {
+        FillContourWords(rccode, heads[k], flat.values.data() + flat.contours[k].first_word, (n_values[k] + 7) / 8);
+    });
+}
+
+// Values of the contour starting from the max point head, whose elems are marked with chain_pos
+template <typename Topology>
+size_t CountContourValues(const BasicRCCode<Topology>& rccode, unsigned head, vector<int>& used_elems, int chain_pos) {
+
+    size_t count = 0;
+    unsigned elem = head;
+    do {
+        count += rccode.Left(elem).value_count + rccode.Right(elem).value_count;
+        used_elems[elem] = chain_pos;
+        elem = rccode.Next(elem);
+    } while (elem != head);
+    return count;
+}
+
+// Stores all the contours of rccode in flat, marking every elem with the position of its contour.
+// A single thread fills each contour right after counting its values, while they are in cache.
+template <typename Topology>
+void RCCodeToFlatChainCode(const BasicRCCode<Topology>& rccode, FlatChainCode& flat, vector<int>& used_elems, unsigned n_threads) {
+
+    flat.Clear();
+
+    if (n_threads <= 1) {
+        for (unsigned i = 0; i < rccode.Size(); i++) {
+            if (used_elems[i] == -1) {
+                const size_t n_values = CountContourValues(rccode, i, used_elems, static_cast<int>(flat.Size()));
+                AppendFlatContour(rccode, i, n_values, flat);
+            }
+        }
+        return;
+    }
+
+    vector<unsigned> heads;
+    vector<size_t> n_values;
+    FindContourHeads(rccode, used_elems, 0, heads, n_values);
+    BuildFlatChainCode(rccode, heads, n_values, flat, n_threads);
+}
+
+void RCCodeToChainCode(const RCCode& rccode, FlatChainCode& flat, unsigned n_threads) {
+    vector<int> used_elems(rccode.Size(), -1);
+    RCCodeToFlatChainCode(rccode, flat, used_elems, n_threads);
+}
+
+void RCCodeToChainCode(const RCCodeTopology& rccode, FlatChainCode& flat, vector<cv::Vec4i>& hierarchy,
+    ContourRetrieval retrieval, unsigned n_threads) {
+
+    vector<int> used_elems(rccode.Size(), -1);
+
+    if (retrieval == ContourRetrieval::All) {
+        RCCodeToFlatChainCode(rccode, flat, used_elems, n_threads);
+
+        hierarchy = vector<cv::Vec4i>(flat.Size());
+        UpdateHierarchyRec(hierarchy, rccode.tree, RCNodeTree::kRoot, used_elems);
+        return;
+    }
+
+    // Only a few contours are usually kept, so they are converted by a single thread
+    flat.Clear();
+    for (unsigned node : SelectContours(rccode.tree, retrieval)) {
+        const unsigned head = static_cast<unsigned>(rccode.tree[node].elem_index);
+        const size_t n_values = CountContourValues(rccode, head, used_elems, static_cast<int>(flat.Size()));
+        AppendFlatContour(rccode, head, n_values, flat);
+    }
+
+    SiblingsHierarchy(hierarchy, flat.Size());
+}
+
+
+// Steps of the links of right chains, which go downwards: 0 is right, 1 down-right, 2 down and 3
+// down-left. Left chains, followed from their last link, go upwards with the opposite steps.
+static const int kLinkDx[4] = { 1, 1, 0, -1 };
+static const int kLinkDy[4] = { 0, 1, 1, 1 };
+
+// Moves p along the links of a right chain, storing every point reached before position pos of
+// points. Contours are walked in the opposite direction of OpenCV, so they are filled backwards.
+static inline void WalkRightChain(const RCChain& chain, cv::Point& p, cv::Point* points, size_t& pos) {
+
+    const uint32_t* links = chain.data();
+    for (unsigned i = 0; i < chain.value_count; i++) {
+        const unsigned link = (links[i / 16] >> ((i & 15) * 2)) & 3;
+        p.x += kLinkDx[link];
+        p.y += kLinkDy[link];
+        points[--pos] = p;
+    }
+}
+
+// Same as above for a left chain, from its last link
+static inline void WalkLeftChain(const RCChain& chain, cv::Point& p, cv::Point* points, size_t& pos) {
+
+    const uint32_t* links = chain.data();
+    for (unsigned i = chain.value_count; i > 0; i--) {
+        const unsigned link = (links[(i - 1) / 16] >> (((i - 1) & 15) * 2)) & 3;
+        p.x -= kLinkDx[link];
+        p.y -= kLinkDy[link];
+        points[--pos] = p;
+    }
+}
+
+// Stores the points of the contour starting from the max point head, which has n_values values.
+// The last link goes back to head, so it writes the first point.
+template <typename Topology>
+void FillContourPoints(const BasicRCCode<Topology>& rccode, unsigned head, size_t n_values, vector<cv::Point>& points) {
+
+    cv::Point p(static_cast<int>(rccode.Col(head)), static_cast<int>(rccode.Row(head)));
+    points.resize(max<size_t>(n_values, 1));
+    points[0] = p;
+
+    size_t pos = n_values;
+    WalkRightChain(rccode.Right(head), p, points.data(), pos);
+    for (unsigned elem = rccode.Next(head); elem != head; elem = rccode.Next(elem)) {
+        WalkLeftChain(rccode.Left(elem), p, points.data(), pos);
+        WalkRightChain(rccode.Right(elem), p, points.data(), pos);
+    }
+    WalkLeftChain(rccode.Left(head), p, points.data(), pos);
+}
+
+// Stores all the contours of rccode in contours, marking every elem with the position of its contour
+template <typename Topology>
+void RCCodeToContoursInternal(const BasicRCCode<Topology>& rccode, vector<vector<cv::Point>>& contours,
+    vector<int>& used_elems, unsigned n_threads) {
+
+    if (n_threads <= 1) {
+        size_t n_contours = 0;
+        for (unsigned i = 0; i < rccode.Size(); i++) {
+            if (used_elems[i] == -1) {
+                const size_t n_values = CountContourValues(rccode, i, used_elems, static_cast<int>(n_contours));
+                if (n_contours == contours.size()) {
+                    contours.emplace_back();
+                }
+                FillContourPoints(rccode, i, n_values, contours[n_contours++]);
+            }
+        }
+        contours.resize(n_contours);
+        return;
+    }
+
+    vector<unsigned> heads;
+    vector<size_t> n_values;
+    FindContourHeads(rccode, used_elems, 0, heads, n_values);
+
+    contours.resize(heads.size());
+    ForEachContour(heads.size(), n_threads, [&](unsigned k) {
+        FillContourPoints(rccode, heads[k], n_values[k], contours[k]);
+    });
+}
+
+void RCCodeToContours(const RCCode& rccode, vector<vector<cv::Point>>& contours, unsigned n_threads) {
+    vector<int> used_elems(rccode.Size(), -1);
+    RCCodeToContoursInternal(rccode, contours, used_elems, n_threads);
+}
+
+void RCCodeToContours(const RCCodeTopology& rccode, vector<vector<cv::Point>>& contours, vector<cv::Vec4i>& hierarchy,
+    ContourRetrieval retrieval, unsigned n_threads) {
+
+    vector<int> used_elems(rccode.Size(), -1);
+
+    if (retrieval == ContourRetrieval::All) {
+        RCCodeToContoursInternal(rccode, contours, used_elems, n_threads);
+
+        hierarchy = vector<cv::Vec4i>(contours.size());
+        UpdateHierarchyRec(hierarchy, rccode.tree, RCNodeTree::kRoot, used_elems);
+        return;
+    }
+
+    const vector<unsigned> nodes = SelectContours(rccode.tree, retrieval);
+    contours.resize(nodes.size());
+    for (size_t k = 0; k < nodes.size(); k++) {
+        const unsigned head = static_cast<unsigned>(rccode.tree[nodes[k]].elem_index);
+        const size_t n_values = CountContourValues(rccode, head, used_elems, static_cast<int>(k));
+        FillContourPoints(rccode, head, n_values, contours[k]);
+    }
+
+    SiblingsHierarchy(hierarchy, contours.size());
+}
+
+void LazyChainCode::Reset(RCCode&& rccode) {
+
+    Clear();
+    rccode_ = std::move(rccode);
+
+    used_elems_.assign(rccode_.Size(), -1);
+    FindContourHeads(rccode_, used_elems_, 0, heads_, value_counts_);
+    total_values_ = accumulate(value_counts_.begin(), value_counts_.end(), size_t(0));
+}
+
+void LazyChainCode::Clear() {
+    {
+        RCCode previous(std::move(rccode_));
+    }
+    heads_.clear();
+    value_counts_.clear();
+    total_values_ = 0;
+    decoded_values_ = 0;
+}
+
+ChainCode::Chain LazyChainCode::Decode(size_t i) const {
+    ChainCode::Chain chain;
+    BuildChain(rccode_, heads_[i], value_counts_[i], chain);
+    decoded_values_ += value_counts_[i];
+    return chain;
+}
+
+ChainCode LazyChainCode::ToChainCode() const {
+    ChainCode chcode;
+    chcode.chains.reserve(Size());
+    for (size_t i = 0; i < Size(); i++) {
+        chcode.chains.push_back(Decode(i));
+    }
+    return chcode;
+}
+
+void LazyChainCode::ToFlatChainCode(FlatChainCode& flat) const {
+    flat.Clear();
+    for (size_t i = 0; i < Size(); i++) {
+        AppendFlatContour(rccode_, heads_[i], value_counts_[i], flat);
+    }
+    decoded_values_ = total_values_;
+}
+
+void MergeRCCodeStrips(vector<RCCode>& strips, const vector<unsigned>& incoming_chains,
+    const vector<vector<unsigned>>& outgoing_chains, RCCode& rccode) {
+
+    size_t total_elems = 0;
+    for (size_t s = 0; s < strips.size(); ++s) {
+        total_elems += strips[s].Size() - incoming_chains[s];
+    }
+    rccode.Reserve(rccode.Size() + total_elems);
+
+    // Position in rccode of every elem of the previous strip
+    vector<unsigned> prev_mapping;
+
+    for (size_t s = 0; s < strips.size(); ++s) {
+
+        RCCode& strip = strips[s];
+        const unsigned n_placeholders = incoming_chains[s];
+        const unsigned n_elems = static_cast<unsigned>(strip.Size());
+
+        vector<unsigned> mapping(n_elems);
+
+        // A placeholder stands for the elem owning the matching chain of the previous strip
+        for (unsigned i = 0; i < n_placeholders; ++i) {
+            mapping[i] = prev_mapping[outgoing_chains[s - 1][i]];
+        }
+
+        const unsigned offset = static_cast<unsigned>(rccode.Size());
+        for (unsigned i = n_placeholders; i < n_elems; ++i) {
+            mapping[i] = offset + (i - n_placeholders);
+        }
+
+        // Real elems are moved as they are, with their links translated
+        for (unsigned i = n_placeholders; i < n_elems; ++i) {
+            RCCode::ElemRef elem = strip[i];
+            elem.next = mapping[elem.next];
+            rccode.AppendElem(strip, i);
+        }
+
+        // Placeholders extend the chains of their owners and may close them
+        for (unsigned i = 0; i < n_placeholders; ++i) {
+            RCCode::ConstElemRef placeholder = strip[i];
+            RCCode::ElemRef owner = rccode[mapping[i]];
+
+            owner.left.append(placeholder.left);
+            owner.right.append(placeholder.right);
+
+            if (placeholder.next != i) {
+                owner.next = mapping[placeholder.next];
+            }
+        }
+
+        prev_mapping = std::move(mapping);
+        strip.ClearStorage();
+    }
 }
 
 
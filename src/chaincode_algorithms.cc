@@ -7,7 +7,7 @@
 
 #include "chaincode_algorithms.h"
 
-cv::Mat1b ChainCodeAlg::img_;
+#include "parallel.h"
 
 ChainCodeAlgMapSingleton& ChainCodeAlgMapSingleton::GetInstance()
 {
@@ -21,11 +21,119 @@ ChainCodeAlg* ChainCodeAlgMapSingleton::GetChainCodeAlg(const std::string& s)
     return ChainCodeAlgMapSingleton::GetInstance().data_.at(s);
 }
 
+std::unique_ptr<ChainCodeAlg> ChainCodeAlgMapSingleton::NewChainCodeAlg(const std::string& s)
+{
+    return std::unique_ptr<ChainCodeAlg>(ChainCodeAlgMapSingleton::GetInstance().factories_.at(s)());
+}
+
 bool ChainCodeAlgMapSingleton::Exists(const std::string& s)
 {
     return ChainCodeAlgMapSingleton::GetInstance().data_.end() != ChainCodeAlgMapSingleton::GetInstance().data_.find(s);
 }
 
+void ChainCodeAlg::StoreContours(RCCode& rccode, unsigned n_threads)
+{
+    if (lazy_output_) {
+        lazy_chain_code_.Reset(std::move(rccode));
+    }
+    else if (points_output_) {
+        RCCodeToContours(rccode, contours_, n_threads);
+    }
+    else if (flat_output_) {
+        RCCodeToChainCode(rccode, flat_chain_code_, n_threads);
+    }
+    else if (n_threads > 1) {
+        RCCodeToChainCode(rccode, chain_code_, n_threads);
+    }
+    else {
+        RCCodeToChainCode(rccode, chain_code_);
+    }
+}
+
+void ChainCodeAlg::StoreContours(const RCCodeTopology& rccode, unsigned n_threads)
+{
+    if (points_output_) {
+        RCCodeToContours(rccode, contours_, hierarchy_, retrieval_, n_threads);
+    }
+    else if (flat_output_) {
+        RCCodeToChainCode(rccode, flat_chain_code_, hierarchy_, retrieval_, n_threads);
+    }
+    else if (n_threads > 1 && retrieval_ == ContourRetrieval::All) {
+        RCCodeToChainCode(rccode, chain_code_, hierarchy_, n_threads);
+    }
+    else {
+        RCCodeToChainCode(rccode, chain_code_, hierarchy_, retrieval_);
+    }
+}
+
+void ChainCodeAlg::StoreContours(const std::vector<std::vector<cv::Point>>& cv_contours, bool contrary)
+{
+    if (flat_output_) {
+        flat_chain_code_.Assign(cv_contours, contrary);
+    }
+    else {
+        chain_code_ = ChainCode(cv_contours, contrary);
+    }
+}
+
+ChainCode ChainCodeAlg::TakeChainCode()
+{
+    if (lazy_output_) {
+        return lazy_chain_code_.ToChainCode();
+    }
+    else if (points_output_) {
+        return ChainCode(contours_, true);
+    }
+    else if (flat_output_) {
+        return flat_chain_code_.ToChainCode();
+    }
+    return std::move(chain_code_);
+}
+
+FlatChainCode ChainCodeAlg::TakeFlatChainCode()
+{
+    FlatChainCode flat;
+    if (lazy_output_) {
+        lazy_chain_code_.ToFlatChainCode(flat);
+    }
+    else if (points_output_) {
+        flat.Assign(contours_, true);
+    }
+    else if (flat_output_) {
+        flat = std::move(flat_chain_code_);
+    }
+    else {
+        flat.Assign(chain_code_);
+    }
+    return flat;
+}
+
+std::vector<BatchResult> PerformChainCodeBatch(const std::string& alg_name, const std::vector<cv::Mat1b>& imgs, unsigned n_threads)
+{
+    n_threads = std::max(1u, std::min(n_threads, static_cast<unsigned>(imgs.size())));
+
+    std::vector<std::unique_ptr<ChainCodeAlg>> algorithms(n_threads);
+    for (auto& algorithm : algorithms) {
+        algorithm = ChainCodeAlgMapSingleton::NewChainCodeAlg(alg_name);
+        try {
+            algorithm->SetThreadsNumber(1);
+        }
+        catch (const std::runtime_error&) {}
+    }
+
+    std::vector<BatchResult> results(imgs.size());
+    ParallelForDynamic(static_cast<unsigned>(imgs.size()), n_threads, [&](unsigned thread, unsigned i) {
+        ChainCodeAlg& algorithm = *algorithms[thread];
+        algorithm.img_ = imgs[i];
+        algorithm.PerformChainCode();
+        results[i].flat_chain_code = algorithm.TakeFlatChainCode();
+        results[i].hierarchy = std::move(algorithm.hierarchy_);
+        algorithm.FreeChainCodeData();
+    });
+
+    return results;
+}
+
 std::string Step(StepType n_step)
 {
     switch (n_step) {
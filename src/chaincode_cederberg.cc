@@ -12,6 +12,7 @@
 
 #include <opencv2/imgproc.hpp>
 
+#include "background_runs.h"
 #include "register.h"
 
 
@@ -195,7 +196,7 @@ bool FillLookupTable(string filename = "cederberg_lut.inc", string table_name =
         return false;
     }
 
-    os << "static unsigned int (*" << table_name << "[512]) (int r, int c, RCCode & rccode, vector<unsigned> & chains, unsigned int pos) = {\n";
+    os << "static unsigned int (*" << table_name << "[512]) (int r, int c, RCCode & rccode, ActiveChains & chains, unsigned int pos) = {\n";
 
     for (unsigned short i = 0; i < 512; i++) {
 
@@ -210,28 +211,110 @@ bool FillLookupTable(string filename = "cederberg_lut.inc", string table_name =
     return true;
 }
 
-template <bool outer>
-inline void ConnectChains(RCCode& rccode, vector<unsigned>& chains, unsigned int pos) {
+template <bool outer, typename ActiveChains>
+inline void ConnectChains(RCCode& rccode, ActiveChains& chains, unsigned int pos) {
 
     // outer: first_it is left and second_it is right
     // inner: first_it is right and second_it is left
 
     if (outer) {
-        rccode[chains[pos - 1]].next = chains[pos - 2];
+        rccode.Connect(chains[pos - 1], chains[pos - 2]);
     }
     else {
-        rccode[chains[pos - 2]].next = chains[pos - 1];
+        rccode.Connect(chains[pos - 2], chains[pos - 1]);
     }
 
     // Remove chains from vector
-    chains.erase(chains.begin() + pos - 2, chains.begin() + pos);
+    chains.ErasePair(pos - 2);
 }
 
-unsigned int ProcessPixelNaive(int r, int c, unsigned short state, RCCode& rccode, vector<unsigned>& chains, unsigned int pos) {
+/*
+With topology every partial contour has a node in the tree of contours. Active chains alternate
+between left chains, along which the scan line enters the foreground, and right chains, along
+which it leaves it, so the region crossed by the scan line right before position pos is given by
+the chain in pos - 1 and by the status of its node.
+*/
+template <typename ActiveChains>
+inline unsigned RegionNode(RCCodeTopology& rccode, const ActiveChains& chains, unsigned int pos) {
+
+    if (pos == 0) {
+        return RCNodeTree::kRoot;
+    }
+
+    const unsigned node = rccode.Node(chains[pos - 1]);
+    const bool entering_foreground = (pos - 1) % 2 == 0;
+    const RCNode::Status status = rccode.tree[node].status;
+    const bool object = status == RCNode::Status::potO || status == RCNode::Status::O;
+
+    // Left chain of an object or right chain of a hole: the region is the node itself,
+    // otherwise it is the one around it
+    return entering_foreground == object ? node : rccode.tree.Parent(node);
+}
+
+// Adds the max point of a new contour, whose chains are going to be inserted before pos
+template <bool outer, typename ActiveChains>
+inline unsigned AddMaxPoint(int r, int c, RCCode& rccode, const ActiveChains& chains, unsigned int pos) {
+    return rccode.AddElem(r, c);
+}
+
+template <bool outer, typename ActiveChains>
+inline unsigned AddMaxPoint(int r, int c, RCCodeTopology& rccode, const ActiveChains& chains, unsigned int pos) {
+
+    // An outer contour lies in a hole (or in the background), and a hole in an object
+    const unsigned parent = RegionNode(rccode, chains, pos);
+    const unsigned node = rccode.tree.EmplaceChild(parent, static_cast<int>(rccode.Size()), outer ? RCNode::Status::potO : RCNode::Status::potH);
+    return rccode.AddElem(r, c, node);
+}
+
+template <bool outer, typename ActiveChains>
+inline void ConnectChains(RCCodeTopology& rccode, ActiveChains& chains, unsigned int pos) {
+
+    const unsigned left = chains[pos - 2];
+    const unsigned right = chains[pos - 1];
+    const unsigned l = rccode.Node(left);
+    const unsigned r = rccode.Node(right);
+    RCNodeTree& tree = rccode.tree;
+
+    // outer: left is the left chain and right is the right one
+    // inner: left is the right chain and right is the left one
+
+    if (outer) {
+        rccode[right].next = left;
+    }
+    else {
+        rccode[left].next = right;
+    }
+
+    // Remove chains from vector
+    chains.ErasePair(pos - 2);
+
+    if (l == r) {
+        // The contour is closed
+        tree[l].status = tree[l].status == RCNode::Status::potH ? RCNode::Status::H : RCNode::Status::O;
+    }
+    else if (tree[l].status == tree[r].status) {
+        tree.Merge(l, r);
+    }
+    else {
+        // Chains meeting in an outer min point belong to an outer contour, in an inner one to a hole
+        const unsigned object = tree[l].status == RCNode::Status::potO ? l : r;
+        const unsigned hole = object == l ? r : l;
+        if (outer) {
+            tree.Merge(object, hole, true);
+        }
+        else {
+            tree.Merge(hole, object, true);
+        }
+    }
+}
+
+template <typename RCCodeType, typename ActiveChains>
+unsigned int ProcessPixelNaive(int r, int c, unsigned short state, RCCodeType& rccode, ActiveChains& chains, unsigned int pos) {
 
     if (state == 10) {
         // state == 10 is the only single-pixel case
-        rccode.AddElem(r, c);
+        const unsigned elem = AddMaxPoint<true>(r, c, rccode, chains, pos);
+        rccode.Connect(elem, elem);
         return pos;
     }
 
@@ -309,9 +392,9 @@ unsigned int ProcessPixelNaive(int r, int c, unsigned short state, RCCode& rccod
     bool last_found_right = false;
 
     if (state & MAX_OUTER) {
-        rccode.AddElem(r, c);
+        const unsigned elem = AddMaxPoint<true>(r, c, rccode, chains, pos);
 
-        chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
+        chains.InsertPair(pos, elem);
 
         pos += 2;
 
@@ -412,14 +495,10 @@ unsigned int ProcessPixelNaive(int r, int c, unsigned short state, RCCode& rccod
     }
 
     if (state & MAX_INNER) {
-        rccode.AddElem(r, c);
+        const unsigned insert_pos = last_found_right ? pos - 1 : pos;
+        const unsigned elem = AddMaxPoint<false>(r, c, rccode, chains, insert_pos);
 
-        if (last_found_right) {
-            chains.insert(chains.begin() + pos - 1, 2, static_cast<int>(rccode.Size()) - 1);
-        }
-        else {
-            chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
-        }
+        chains.InsertPair(insert_pos, elem);
 
         pos += 2;
     }
@@ -428,12 +507,13 @@ unsigned int ProcessPixelNaive(int r, int c, unsigned short state, RCCode& rccod
 
 }
 
-template <unsigned short state>
-inline unsigned int ProcessPixel(int r, int c, RCCode& rccode, vector<unsigned>& chains, unsigned int pos) {
+template <unsigned short state, typename RCCodeType, typename ActiveChains>
+inline unsigned int ProcessPixel(int r, int c, RCCodeType& rccode, ActiveChains& chains, unsigned int pos) {
 
     if (state == 10) {
         // state == 10 is the only single-pixel case
-        rccode.AddElem(r, c);
+        const unsigned elem = AddMaxPoint<true>(r, c, rccode, chains, pos);
+        rccode.Connect(elem, elem);
         return pos;
     }
 
@@ -511,9 +591,9 @@ inline unsigned int ProcessPixel(int r, int c, RCCode& rccode, vector<unsigned>&
     bool last_found_right = false;
 
     if (state & MAX_OUTER) {
-        rccode.AddElem(r, c);
+        const unsigned elem = AddMaxPoint<true>(r, c, rccode, chains, pos);
 
-        chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
+        chains.InsertPair(pos, elem);
 
         pos += 2;
 
@@ -614,14 +694,10 @@ inline unsigned int ProcessPixel(int r, int c, RCCode& rccode, vector<unsigned>&
     }
 
     if (state & MAX_INNER) {
-        rccode.AddElem(r, c);
+        const unsigned insert_pos = last_found_right ? pos - 1 : pos;
+        const unsigned elem = AddMaxPoint<false>(r, c, rccode, chains, insert_pos);
 
-        if (last_found_right) {
-            chains.insert(chains.begin() + pos - 1, 2, static_cast<int>(rccode.Size()) - 1);
-        }
-        else {
-            chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
-        }
+        chains.InsertPair(insert_pos, elem);
 
         pos += 2;
     }
@@ -629,11 +705,12 @@ inline unsigned int ProcessPixel(int r, int c, RCCode& rccode, vector<unsigned>&
     return pos;
 }
 
-void Cederberg::PerformChainCode() {
+template <typename ActiveChains>
+void Cederberg<ActiveChains>::PerformChainCode() {
 
-    RCCode rccode;
+    RCCode rccode(workspace_, contour_sink_);
 
-    vector<unsigned> chains;
+    ActiveChains chains;
 
     int h = img_.rows;
     int w = img_.cols;
@@ -670,16 +747,17 @@ void Cederberg::PerformChainCode() {
         next_row_ptr += img_.step[0];
     }
 
-    RCCodeToChainCode(rccode, chain_code_);
+    StoreContours(rccode);
 }
 
-void Cederberg_LUT::PerformChainCode() {
+template <typename ActiveChains>
+void Cederberg_LUT<ActiveChains>::PerformChainCode() {
 
-    RCCode rccode;
+    RCCode rccode(workspace_, contour_sink_);
 
 #include "cederberg_lut.inc"
 
-    vector<unsigned> chains;
+    ActiveChains chains;
 
     const unsigned char* previous_row_ptr = nullptr;
     const unsigned char* row_ptr = img_.ptr(0);
@@ -711,16 +789,91 @@ void Cederberg_LUT::PerformChainCode() {
         next_row_ptr += img_.step[0];
     }
 
-    RCCodeToChainCode(rccode, chain_code_);
+    StoreContours(rccode);
+}
+
+// Condition of the pixel in column c of row_ptr, whose neighbors can all be read
+inline unsigned short PaddedCondition(const uint8_t* previous_row_ptr, const uint8_t* row_ptr,
+    const uint8_t* next_row_ptr, int c) {
+
+    unsigned short condition = 0;
+
+    if (previous_row_ptr[c - 1])    condition |= PIXEL_A;
+    if (previous_row_ptr[c])        condition |= PIXEL_B;
+    if (previous_row_ptr[c + 1])    condition |= PIXEL_C;
+    if (row_ptr[c - 1])             condition |= PIXEL_D;
+    if (row_ptr[c])                 condition |= PIXEL_X;
+    if (row_ptr[c + 1])             condition |= PIXEL_E;
+    if (next_row_ptr[c - 1])        condition |= PIXEL_F;
+    if (next_row_ptr[c])            condition |= PIXEL_G;
+    if (next_row_ptr[c + 1])        condition |= PIXEL_H;
+
+    return condition;
+}
+
+template <typename ActiveChains>
+void Cederberg_Padded<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+    ActiveChains chains;
+
+    padded_img_.Pad(img_);
+
+    // Build Raster Scan Chain Code
+    for (int r = 0; r < padded_img_.rows; r++) {
+        unsigned int pos = 0;
+
+        const uint8_t* previous_row_ptr = padded_img_.Row(r - 1);
+        const uint8_t* row_ptr = padded_img_.Row(r);
+        const uint8_t* next_row_ptr = padded_img_.Row(r + 1);
+
+        for (int c = 0; c < padded_img_.cols; c++) {
+            unsigned short condition = PaddedCondition(previous_row_ptr, row_ptr, next_row_ptr, c);
+            unsigned short state = TemplateCheck::CheckState(condition);
+            pos = ProcessPixelNaive(r, c, state, rccode, chains, pos);
+        }
+    }
+
+    StoreContours(rccode);
+}
+
+template <typename ActiveChains>
+void Cederberg_LUT_Padded<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+#include "cederberg_lut.inc"
+
+    ActiveChains chains;
+
+    padded_img_.Pad(img_);
+
+    // Build Raster Scan Chain Code
+    for (int r = 0; r < padded_img_.rows; r++) {
+        unsigned int pos = 0;
+
+        const uint8_t* previous_row_ptr = padded_img_.Row(r - 1);
+        const uint8_t* row_ptr = padded_img_.Row(r);
+        const uint8_t* next_row_ptr = padded_img_.Row(r + 1);
+
+        for (int c = 0; c < padded_img_.cols; c++) {
+            unsigned short condition = PaddedCondition(previous_row_ptr, row_ptr, next_row_ptr, c);
+            pos = table[condition](r, c, rccode, chains, pos);
+        }
+    }
+
+    StoreContours(rccode);
 }
 
-void Cederberg_LUT_PRED::PerformChainCode() {
+template <typename ActiveChains>
+void Cederberg_LUT_PRED<ActiveChains>::PerformChainCode() {
 
-    RCCode rccode;
+    RCCode rccode(workspace_, contour_sink_);
 
 #include "cederberg_lut.inc"
 
-    vector<unsigned> chains;
+    ActiveChains chains;
 
     const unsigned char* previous_row_ptr = nullptr;
     const unsigned char* row_ptr = img_.ptr(0);
@@ -766,17 +919,388 @@ void Cederberg_LUT_PRED::PerformChainCode() {
         next_row_ptr += img_.step[0];
     }
 
-    RCCodeToChainCode(rccode, chain_code_);
+    StoreContours(rccode);
+}
+
+template <typename ActiveChains>
+void Cederberg_Packed<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+#include "cederberg_lut.inc"
+
+    ActiveChains chains;
+
+    packed_img_.Pack(img_);
+    const int w = packed_img_.cols;
+
+    // Build Raster Scan Chain Code
+    for (int r = 0; r < packed_img_.rows; r++) {
+        unsigned int pos = 0;
+
+        // Rows outside the image and columns -1 and w are background
+        const uint64_t* previous_row = packed_img_.Row(r - 1);
+        const uint64_t* row = packed_img_.Row(r);
+        const uint64_t* next_row = packed_img_.Row(r + 1);
+
+        // Condition of column -1, whose right neighbors are in column 0
+        unsigned short condition = 0;
+        condition |= BitImage::Pixel(previous_row, 0) * PIXEL_C;
+        condition |= BitImage::Pixel(row, 0) * PIXEL_E;
+        condition |= BitImage::Pixel(next_row, 0) * PIXEL_H;
+
+        for (int c = 0; c < w; c++) {
+
+            condition >>= 1;
+            condition &= ~(PIXEL_C | PIXEL_E | PIXEL_H);
+
+            condition |= BitImage::Pixel(previous_row, c + 1) * PIXEL_C;
+            condition |= BitImage::Pixel(row, c + 1) * PIXEL_E;
+            condition |= BitImage::Pixel(next_row, c + 1) * PIXEL_H;
+
+            if (condition == 0) {
+                // Background pixels whose neighborhood is background as well do nothing: the
+                // scan goes on from the column before the next foreground one
+                c = std::max(c, packed_img_.NextForegroundColumn(c + 2, previous_row, row, next_row) - 2);
+                continue;
+            }
+
+            pos = table[condition](r, c, rccode, chains, pos);
+        }
+    }
+
+    StoreContours(rccode);
+}
+
+template <typename ActiveChains>
+void Cederberg_EdgeMask<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+#include "cederberg_lut.inc"
+
+    ActiveChains chains;
+
+    packed_img_.Pack(img_);
+
+    for (int r = 0; r < packed_img_.rows; r++) {
+        unsigned int pos = 0;
+
+        const uint64_t* previous_row = packed_img_.Row(r - 1);
+        const uint64_t* row = packed_img_.Row(r);
+        const uint64_t* next_row = packed_img_.Row(r + 1);
+
+        // Condition of a pixel whose bit is set in the mask, so c is a foreground column
+        auto condition_at = [&](int c) {
+            unsigned short condition = PIXEL_X;
+            if (c > 0) {
+                condition |= BitImage::Pixel(previous_row, c - 1) * PIXEL_A;
+                condition |= BitImage::Pixel(row, c - 1) * PIXEL_D;
+                condition |= BitImage::Pixel(next_row, c - 1) * PIXEL_F;
+            }
+            condition |= BitImage::Pixel(previous_row, c) * PIXEL_B;
+            condition |= BitImage::Pixel(next_row, c) * PIXEL_G;
+            condition |= BitImage::Pixel(previous_row, c + 1) * PIXEL_C;
+            condition |= BitImage::Pixel(row, c + 1) * PIXEL_E;
+            condition |= BitImage::Pixel(next_row, c + 1) * PIXEL_H;
+            return condition;
+        };
+
+        for (int k = 0; k < packed_img_.words_per_row; k++) {
+            const uint64_t x = row[k];
+            if (x == 0) {
+                continue;
+            }
+
+            // Mask of the foreground pixels with a background 4-neighbor, which are the only
+            // ones with an action in the table: 64 pixels at a time
+            const uint64_t left = (x << 1) | (k > 0 ? row[k - 1] >> 63 : 0);
+            const uint64_t right = (x >> 1) | (k + 1 < packed_img_.words_per_row ? row[k + 1] << 63 : 0);
+            uint64_t mask = x & ~(previous_row[k] & next_row[k] & left & right);
+
+            for (; mask != 0; mask &= mask - 1) {
+                const int c = (k << 6) + static_cast<int>(CountTrailingZeros64(mask));
+                pos = table[condition_at(c)](r, c, rccode, chains, pos);
+            }
+        }
+    }
+
+    StoreContours(rccode);
+}
+
+// Condition of the pixel in the middle of three columns, each given as 3 bits from top to bottom
+inline unsigned short ColumnsCondition(unsigned left, unsigned center, unsigned right) {
+    return static_cast<unsigned short>(
+        (left & 1) * PIXEL_A | (center & 1) * PIXEL_B | (right & 1) * PIXEL_C |
+        (left >> 1 & 1) * PIXEL_D | (center >> 1 & 1) * PIXEL_X | (right >> 1 & 1) * PIXEL_E |
+        (left >> 2 & 1) * PIXEL_F | (center >> 2 & 1) * PIXEL_G | (right >> 2 & 1) * PIXEL_H);
+}
+
+// Whether the pixel with this condition does something, i.e. it is a foreground pixel with a
+// background 4-neighbor
+inline bool HasAction(unsigned short condition) {
+    const unsigned short four_neighbors = PIXEL_B | PIXEL_D | PIXEL_E | PIXEL_G;
+    return (condition & PIXEL_X) && (condition & four_neighbors) != four_neighbors;
+}
+
+template <typename ActiveChains>
+void Cederberg_LUT_TwoRows<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+#include "cederberg_lut.inc"
+
+    ActiveChains chains;
+
+    const int w = img_.cols;
+    const int h = img_.rows;
+    background_row_.assign(w, 0);
+
+    auto row_or_background = [&](int r) {
+        return r >= 0 && r < h ? img_.ptr(r) : background_row_.data();
+    };
+
+    for (int r = 0; r < h; r += 2) {
+        unsigned int pos = 0;
+
+        const uint8_t* const rows[4] = { row_or_background(r - 1), row_or_background(r),
+            row_or_background(r + 1), row_or_background(r + 2) };
+
+        // Column c of rows r - 1 to r + 2, from the least significant bit
+        auto column = [&rows](int c) {
+            return unsigned(rows[0][c] != 0) | unsigned(rows[1][c] != 0) << 1 |
+                unsigned(rows[2][c] != 0) << 2 | unsigned(rows[3][c] != 0) << 3;
+        };
+
+        // The actions of row r are taken during the scan, those of row r + 1 are delayed
+        // until its end, so that each row is read once for both
+        events_.clear();
+
+        unsigned left = 0;
+        unsigned center = column(0);
+        for (int c = 0; c < w; c++) {
+            unsigned right = c + 1 < w ? column(c + 1) : 0;
+
+            if ((left | center | right) == 0) {
+                // The 4 x 3 window is background: jump to the column before the next foreground one
+                const int next = NextForegroundColumn(c + 2, w, rows[0], rows[1], rows[2], rows[3]);
+                if (next == w) {
+                    break;
+                }
+                c = next - 1;
+                left = 0;
+                center = 0;
+                right = column(next);
+            }
+
+            if ((left & center & right) == 0xF) {
+                // Both pixels are inside a foreground region
+                left = center;
+                center = right;
+                continue;
+            }
+
+            const unsigned short upper = ColumnsCondition(left, center, right);
+            if (HasAction(upper)) {
+                pos = table[upper](r, c, rccode, chains, pos);
+            }
+
+            const unsigned short lower = ColumnsCondition(left >> 1, center >> 1, right >> 1);
+            if (HasAction(lower)) {
+                events_.push_back({ c, lower });
+            }
+
+            left = center;
+            center = right;
+        }
+
+        // Row h does not exist when h is odd, and it is background in the window
+        pos = 0;
+        for (const PixelEvent& event : events_) {
+            pos = table[event.condition](r + 1, event.col, rccode, chains, pos);
+        }
+    }
+
+    StoreContours(rccode);
+}
+
+namespace {
+
+// First phase of Cederberg_TwoPhase: appends to events the pixels of a row which do something,
+// that is the foreground pixels with a background 4-neighbor, along with their condition. Rows
+// above and below the image must be given as background rows of the same width.
+void ClassifyRow(const uint8_t* previous_row_ptr, const uint8_t* row_ptr, const uint8_t* next_row_ptr, int w,
+    std::vector<PixelEvent>& events) {
+
+    auto classify_pixel = [&](int c) {
+        if (!row_ptr[c]) {
+            return;
+        }
+        const bool left = c > 0;
+        const bool right = c + 1 < w;
+
+        unsigned short condition = PIXEL_X;
+        if (left && previous_row_ptr[c - 1])    condition |= PIXEL_A;
+        if (previous_row_ptr[c])                condition |= PIXEL_B;
+        if (right && previous_row_ptr[c + 1])   condition |= PIXEL_C;
+        if (left && row_ptr[c - 1])             condition |= PIXEL_D;
+        if (right && row_ptr[c + 1])            condition |= PIXEL_E;
+        if (left && next_row_ptr[c - 1])        condition |= PIXEL_F;
+        if (next_row_ptr[c])                    condition |= PIXEL_G;
+        if (right && next_row_ptr[c + 1])       condition |= PIXEL_H;
+
+        const unsigned short four_neighbors = PIXEL_B | PIXEL_D | PIXEL_E | PIXEL_G;
+        if ((condition & four_neighbors) != four_neighbors) {
+            events.push_back({ c, condition });
+        }
+    };
+
+    if (w == 0) {
+        return;
+    }
+    classify_pixel(0);
+    int c = 1;
+
+#ifdef BACCA_USE_AVX2
+    // 32 pixels at a time, as long as their neighborhood is inside the row
+    const __m256i zero32 = _mm256_setzero_si256();
+    auto background32 = [zero32](const uint8_t* pixels) {
+        return _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels)), zero32);
+    };
+    auto bit_if_foreground32 = [](__m256i background, unsigned bit) {
+        return _mm256_andnot_si256(background, _mm256_set1_epi8(static_cast<char>(bit)));
+    };
+
+    for (; c + 32 < w; c += 32) {
+        const __m256i a = background32(previous_row_ptr + c - 1);
+        const __m256i b = background32(previous_row_ptr + c);
+        const __m256i cc = background32(previous_row_ptr + c + 1);
+        const __m256i d = background32(row_ptr + c - 1);
+        const __m256i x = background32(row_ptr + c);
+        const __m256i e = background32(row_ptr + c + 1);
+        const __m256i f = background32(next_row_ptr + c - 1);
+        const __m256i g = background32(next_row_ptr + c);
+        const __m256i h = background32(next_row_ptr + c + 1);
+
+        const __m256i border = _mm256_or_si256(_mm256_or_si256(b, d), _mm256_or_si256(e, g));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_andnot_si256(x, border)));
+        if (mask == 0) {
+            continue;
+        }
+
+        // Conditions of the 32 pixels: the 8 low bits, then PIXEL_H
+        __m256i low = _mm256_or_si256(bit_if_foreground32(a, PIXEL_A), bit_if_foreground32(b, PIXEL_B));
+        low = _mm256_or_si256(low, _mm256_or_si256(bit_if_foreground32(cc, PIXEL_C), bit_if_foreground32(d, PIXEL_D)));
+        low = _mm256_or_si256(low, _mm256_or_si256(bit_if_foreground32(x, PIXEL_X), bit_if_foreground32(e, PIXEL_E)));
+        low = _mm256_or_si256(low, _mm256_or_si256(bit_if_foreground32(f, PIXEL_F), bit_if_foreground32(g, PIXEL_G)));
+        const __m256i high = bit_if_foreground32(h, 1);
+
+        // The unpacking works inside each 128-bit lane, which the permutations put back in order
+        const __m256i unpacked_lo = _mm256_unpacklo_epi8(low, high);
+        const __m256i unpacked_hi = _mm256_unpackhi_epi8(low, high);
+        alignas(32) uint16_t conditions[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(conditions), _mm256_permute2x128_si256(unpacked_lo, unpacked_hi, 0x20));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(conditions + 16), _mm256_permute2x128_si256(unpacked_lo, unpacked_hi, 0x31));
+
+        for (; mask != 0; mask &= mask - 1) {
+            const unsigned i = CountTrailingZeros(mask);
+            events.push_back({ c + static_cast<int>(i), conditions[i] });
+        }
+    }
+#endif
+
+#ifdef BACCA_USE_SSE2
+    // 16 pixels at a time, as long as their neighborhood is inside the row
+    const __m128i zero = _mm_setzero_si128();
+    auto background = [zero](const uint8_t* pixels) {
+        return _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels)), zero);
+    };
+    auto bit_if_foreground = [](__m128i background, unsigned bit) {
+        return _mm_andnot_si128(background, _mm_set1_epi8(static_cast<char>(bit)));
+    };
+
+    for (; c + 16 < w; c += 16) {
+        const __m128i a = background(previous_row_ptr + c - 1);
+        const __m128i b = background(previous_row_ptr + c);
+        const __m128i cc = background(previous_row_ptr + c + 1);
+        const __m128i d = background(row_ptr + c - 1);
+        const __m128i x = background(row_ptr + c);
+        const __m128i e = background(row_ptr + c + 1);
+        const __m128i f = background(next_row_ptr + c - 1);
+        const __m128i g = background(next_row_ptr + c);
+        const __m128i h = background(next_row_ptr + c + 1);
+
+        const __m128i border = _mm_or_si128(_mm_or_si128(b, d), _mm_or_si128(e, g));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_andnot_si128(x, border)));
+        if (mask == 0) {
+            continue;
+        }
+
+        // Conditions of the 16 pixels: the 8 low bits, then PIXEL_H
+        __m128i low = _mm_or_si128(bit_if_foreground(a, PIXEL_A), bit_if_foreground(b, PIXEL_B));
+        low = _mm_or_si128(low, _mm_or_si128(bit_if_foreground(cc, PIXEL_C), bit_if_foreground(d, PIXEL_D)));
+        low = _mm_or_si128(low, _mm_or_si128(bit_if_foreground(x, PIXEL_X), bit_if_foreground(e, PIXEL_E)));
+        low = _mm_or_si128(low, _mm_or_si128(bit_if_foreground(f, PIXEL_F), bit_if_foreground(g, PIXEL_G)));
+        const __m128i high = bit_if_foreground(h, 1);
+
+        alignas(16) uint16_t conditions[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(conditions), _mm_unpacklo_epi8(low, high));
+        _mm_store_si128(reinterpret_cast<__m128i*>(conditions + 8), _mm_unpackhi_epi8(low, high));
+
+        for (; mask != 0; mask &= mask - 1) {
+            const unsigned i = CountTrailingZeros(mask);
+            events.push_back({ c + static_cast<int>(i), conditions[i] });
+        }
+    }
+#endif
+
+    for (; c < w; c++) {
+        classify_pixel(c);
+    }
+}
+
+}
+
+template <typename ActiveChains>
+void Cederberg_TwoPhase<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+#include "cederberg_lut.inc"
+
+    ActiveChains chains;
+
+    const int w = img_.cols;
+    background_row_.assign(w, 0);
+
+    for (int r = 0; r < img_.rows; r++) {
+
+        const uint8_t* previous_row_ptr = r > 0 ? img_.ptr(r - 1) : background_row_.data();
+        const uint8_t* row_ptr = img_.ptr(r);
+        const uint8_t* next_row_ptr = r + 1 < img_.rows ? img_.ptr(r + 1) : background_row_.data();
+
+        events_.clear();
+        ClassifyRow(previous_row_ptr, row_ptr, next_row_ptr, w, events_);
+
+        // Second phase: only the pixels which do something go through the table
+        unsigned int pos = 0;
+        for (const PixelEvent& event : events_) {
+            pos = table[event.condition](r, event.col, rccode, chains, pos);
+        }
+    }
+
+    StoreContours(rccode);
 }
 
-void Cederberg_DRAG::PerformChainCode() {
+template <typename ActiveChains>
+void Cederberg_DRAG<ActiveChains>::PerformChainCode() {
 
-    RCCode rccode;
+    RCCode rccode(workspace_, contour_sink_);
 
     int w = img_.cols;
     int h = img_.rows;
 
-    vector<unsigned> chains;
+    ActiveChains chains;
 
     const unsigned char* previous_row_ptr = nullptr;
     const unsigned char* row_ptr = img_.ptr(0);
@@ -959,10 +1483,11 @@ void Cederberg_DRAG::PerformChainCode() {
 
     }
 
-    RCCodeToChainCode(rccode, chain_code_);
+    StoreContours(rccode);
 }
 
-void Cederberg_DRAG::PerformChainCodeWithSteps() {
+template <typename ActiveChains>
+void Cederberg_DRAG<ActiveChains>::PerformChainCodeWithSteps() {
 
     perf_.start();
     RCCode rccode = Cederberg_DRAG::PerformRCCode();
@@ -976,11 +1501,12 @@ void Cederberg_DRAG::PerformChainCodeWithSteps() {
 
 }
 
-RCCode Cederberg_DRAG::PerformRCCode() {
+template <typename ActiveChains>
+RCCode Cederberg_DRAG<ActiveChains>::PerformRCCode() {
 
-    RCCode rccode;
+    RCCode rccode(workspace_, contour_sink_);
 
-    vector<unsigned> chains;
+    ActiveChains chains;
 
     int w = img_.cols;
     int h = img_.rows;
@@ -1169,22 +1695,41 @@ RCCode Cederberg_DRAG::PerformRCCode() {
     return rccode;
 }
 
-void Cederberg_DRAG::ConvertToChainCode(const RCCode& rccode) {
-    RCCodeToChainCode(rccode, chain_code_);
+template <typename ActiveChains>
+void Cederberg_DRAG<ActiveChains>::ConvertToChainCode(RCCode& rccode) {
+    StoreContours(rccode);
 }
 
-void Cederberg_Spaghetti::PerformChainCode() {
+template <typename ActiveChains>
+void Cederberg_Spaghetti<ActiveChains>::PerformChainCode() {
+	RCCode rccode = PerformRCCode();
+	StoreContours(rccode);
+}
 
-	RCCode rccode;
+template <typename ActiveChains>
+void Cederberg_Spaghetti<ActiveChains>::PerformChainCodeWithSteps() {
 
-	int w = img_.cols;
-	int h = img_.rows;
+	perf_.start();
+	RCCode rccode = PerformRCCode();
+	perf_.stop();
+	perf_.store(Step(StepType::ALGORITHM), perf_.last());
 
-	vector<unsigned> chains;
+	perf_.start();
+	StoreContours(rccode);
+	perf_.stop();
+	perf_.store(Step(StepType::CONVERSION), perf_.last());
+}
 
-	const unsigned char* previous_row_ptr = nullptr;
-	const unsigned char* row_ptr = img_.ptr(0);
-	const unsigned char* next_row_ptr = row_ptr + img_.step[0];
+// Lines of the image told apart by the Spaghetti forests, which only look at the rows around
+// each row that are in the image
+enum class SpaghettiLine { FIRST, CENTER, LAST, SINGLE };
+
+// Row r of the raster scan of Cederberg_Spaghetti, going on with the chains of the rows before it.
+// The rows around it which are not in the image, according to line, are not looked at and may be
+// nullptr. Shared by the serial, strip and stream algorithms, with and without topology.
+template <typename ActiveChains, typename Topology>
+void CederbergSpaghettiRow(SpaghettiLine line, int r, int w, const unsigned char* previous_row_ptr,
+	const unsigned char* row_ptr, const unsigned char* next_row_ptr, BasicRCCode<Topology>& rccode, ActiveChains& chains) {
 
 #define CONDITION_A     (previous_row_ptr[c - 1])                     
 #define CONDITION_B     (previous_row_ptr[c])                                  
@@ -1196,7 +1741,9 @@ void Cederberg_Spaghetti::PerformChainCode() {
 #define CONDITION_G     (next_row_ptr[c])                          
 #define CONDITION_H     (next_row_ptr[c + 1]) 
 
-#define ACTION_1    pos = ProcessPixel<0	  >(r, c, rccode, chains, pos);
+	// After a background pixel the scan jumps over the rest of the background run, looking at the
+	// rows of the window of each line, see SkipBackground()
+#define ACTION_1    pos = ProcessPixel<0	  >(r, c, rccode, chains, pos); BACKGROUND_RUN
 #define ACTION_2    pos = ProcessPixel<1	  >(r, c, rccode, chains, pos);
 #define ACTION_3    pos = ProcessPixel<2	  >(r, c, rccode, chains, pos);
 #define ACTION_4    pos = ProcessPixel<3	  >(r, c, rccode, chains, pos);
@@ -1262,59 +1809,45 @@ void Cederberg_Spaghetti::PerformChainCode() {
 #define ACTION_64   pos = ProcessPixel<3124>(r, c, rccode, chains, pos);
 #define ACTION_65   pos = ProcessPixel<3132>(r, c, rccode, chains, pos);
 
-	if (h == 1) {
-		int r = 0;
-		int c = -1;
-
-		unsigned int pos = 0;
+	int c = -1;
+	unsigned int pos = 0;
 
-		c = -1;
+	if (line == SpaghettiLine::SINGLE) {
 		goto sl_tree_0;
 
+#define BACKGROUND_RUN c = SkipBackground(c, w, row_ptr);
 #include "Cederberg_Spaghetti_single_line_forest_code.inc.h"
+#undef BACKGROUND_RUN
 
 	}
-	else {
-		int r = 0;
-		int c = -1;
-
-		unsigned int pos = 0;
-
+	else if (line == SpaghettiLine::FIRST) {
 		goto fl_tree_0;
 
-#include "Cederberg_Spaghetti_first_line_forest_code.inc.h"    
-
-		// Build Raster Scan Chain Code
-		for (r = 1; r < h - 1; r++) {
-
-			previous_row_ptr = row_ptr;
-			row_ptr = next_row_ptr;
-			next_row_ptr += img_.step[0];
-
-			pos = 0;
+#define BACKGROUND_RUN c = SkipBackground(c, w, row_ptr, next_row_ptr);
+#include "Cederberg_Spaghetti_first_line_forest_code.inc.h"
+#undef BACKGROUND_RUN
 
-			c = -1;
+	}
+	else if (line == SpaghettiLine::CENTER) {
+		// The center line forest ends every row with a continue
+		do {
 			goto cl_tree_0;
 
+#define BACKGROUND_RUN c = SkipBackground(c, w, previous_row_ptr, row_ptr, next_row_ptr);
 #include "Cederberg_Spaghetti_center_line_forest_code.inc.h"
+#undef BACKGROUND_RUN
 
-		}
-
-		previous_row_ptr = row_ptr;
-		row_ptr = next_row_ptr;
-		next_row_ptr += img_.step[0];
-
-		pos = 0;
-
-		c = -1;
+		} while (false);
+	}
+	else {
 		goto ll_tree_0;
 
+#define BACKGROUND_RUN c = SkipBackground(c, w, previous_row_ptr, row_ptr);
 #include "Cederberg_Spaghetti_last_line_forest_code.inc.h"
+#undef BACKGROUND_RUN
 
 	}
 
-	
-
 #undef ACTION_1 
 #undef ACTION_2 
 #undef ACTION_3 
@@ -1390,20 +1923,217 @@ void Cederberg_Spaghetti::PerformChainCode() {
 #undef CONDITION_F
 #undef CONDITION_G
 #undef CONDITION_H
+}
+
+// Raster scan of Cederberg_Spaghetti on rows [r_begin, r_end), going on with the chains already in
+// chains. The last row of the range also looks at the following one, unless it is the last of the image.
+template <typename ActiveChains, typename Topology>
+void CederbergSpaghettiScan(const Mat1b& img, int r_begin, int r_end, BasicRCCode<Topology>& rccode, ActiveChains& chains) {
+
+	const int h = img.rows;
+
+	for (int r = r_begin; r < r_end; r++) {
+
+		SpaghettiLine line = SpaghettiLine::CENTER;
+		if (h == 1) {
+			line = SpaghettiLine::SINGLE;
+		}
+		else if (r == 0) {
+			line = SpaghettiLine::FIRST;
+		}
+		else if (r == h - 1) {
+			line = SpaghettiLine::LAST;
+		}
+
+		const unsigned char* previous_row_ptr = (r > 0) ? img.ptr(r - 1) : nullptr;
+		const unsigned char* next_row_ptr = (r < h - 1) ? img.ptr(r + 1) : nullptr;
+
+		CederbergSpaghettiRow(line, r, img.cols, previous_row_ptr, img.ptr(r), next_row_ptr, rccode, chains);
+	}
+}
+
+// Raster scan of Cederberg_Spaghetti on the whole image, shared by the algorithms with and without topology
+template <typename ActiveChains, typename Topology>
+void CederbergSpaghettiScan(const Mat1b& img, BasicRCCode<Topology>& rccode) {
+	ActiveChains chains;
+	CederbergSpaghettiScan(img, 0, img.rows, rccode, chains);
+}
+
+template <typename ActiveChains>
+RCCode Cederberg_Spaghetti<ActiveChains>::PerformRCCode() {
+
+	RCCode rccode(workspace_, contour_sink_);
+
+	CederbergSpaghettiScan<ActiveChains>(img_, rccode);
+
+	return rccode;
+}
+
+namespace {
+
+// Number of chains crossing the border between rows r - 1 and r. Chains are monotone along the
+// rows, so each of them gets exactly one vertical or diagonal link (D1, D2 or D3) on row r, and
+// those links only depend on the pixels a, b, c, d, x and e.
+unsigned CountIncomingChains(const unsigned char* previous_row_ptr, const unsigned char* row_ptr, int w) {
+
+	static const vector<uint8_t> links_count = []() {
+		vector<uint8_t> lut(64);
+		for (unsigned short condition = 0; condition < 64; condition++) {
+			unsigned short links = TemplateCheck::CheckState(condition) & (D1A | D1B | D2A | D2B | D3A | D3B);
+			for (; links; links &= links - 1) {
+				lut[condition]++;
+			}
+		}
+		return lut;
+	}();
+
+	unsigned count = 0;
+	for (int c = 0; c < w; c++) {
+
+		if (!row_ptr[c]) {
+			continue;
+		}
+
+		unsigned short condition = PIXEL_X;
+
+		if (c > 0 && previous_row_ptr[c - 1])               condition |= PIXEL_A;
+		if (previous_row_ptr[c])                            condition |= PIXEL_B;
+		if (c + 1 < w && previous_row_ptr[c + 1])           condition |= PIXEL_C;
+		if (c > 0 && row_ptr[c - 1])                        condition |= PIXEL_D;
+		if (c + 1 < w && row_ptr[c + 1])                    condition |= PIXEL_E;
+
+		count += links_count[condition];
+	}
+
+	return count;
+}
+
+}
+
+
+template <typename ActiveChains>
+void Cederberg_Spaghetti_MT<ActiveChains>::PerformChainCode() {
+
+	int h = img_.rows;
+
+	const unsigned n_strips = max(1u, min(n_threads_, static_cast<unsigned>(h)));
+
+	vector<int> strip_begin(n_strips + 1);
+	for (unsigned s = 0; s <= n_strips; s++) {
+		strip_begin[s] = static_cast<int>(static_cast<int64_t>(h) * s / n_strips);
+	}
+
+	// The storage kept by the workspace is shared among the strips, and the strips not used anymore
+	// are released
+	strips_.resize(n_strips);
+	for (RCCode& strip : strips_) {
+		strip.Recycle(workspace_.max_retained_elems / n_strips, workspace_.max_retained_chain_words / n_strips);
+	}
+	vector<unsigned> incoming_chains(n_strips, 0);
+	vector<vector<unsigned>> outgoing_chains(n_strips);
+
+	ParallelFor(n_strips, n_threads_, [&](unsigned s) {
+
+		const int r_begin = strip_begin[s];
+
+		// Chains coming from the previous strip are continued by placeholder elems, which
+		// take the same positions in the active chains vector
+		if (r_begin > 0) {
+			incoming_chains[s] = CountIncomingChains(img_.ptr(r_begin - 1), img_.ptr(r_begin), img_.cols);
+		}
+		for (unsigned i = 0; i < incoming_chains[s]; i++) {
+			strips_[s].AddElem(r_begin, 0);
+		}
+
+		vector<unsigned> placeholders(incoming_chains[s]);
+		iota(placeholders.begin(), placeholders.end(), 0);
 
+		ActiveChains chains(move(placeholders));
+		CederbergSpaghettiScan(img_, r_begin, strip_begin[s + 1], strips_[s], chains);
 
-    RCCodeToChainCode(rccode, chain_code_);
+		outgoing_chains[s] = chains.Values();
+	});
+
+	RCCode rccode(workspace_);
+	MergeRCCodeStrips(strips_, incoming_chains, outgoing_chains, rccode);
+
+	StoreContours(rccode, n_threads_);
+}
+
+
+
+template <typename ActiveChains>
+void Cederberg_Spaghetti_Stream<ActiveChains>::StartStream(unsigned width) {
+	w_ = static_cast<int>(width);
+	n_rows_ = 0;
+	for (auto& row : rows_) {
+		row.assign(width, 0);
+	}
+	// The output of the previous stream, which may hold an RCCode too, is released first
+	FreeChainCodeData();
+	{
+		// An unfinished stream gives its storage back first, so that the new RCCode takes it
+		RCCode previous(std::move(rccode_));
+	}
+	rccode_ = RCCode(workspace_, contour_sink_);
+	chains_ = ActiveChains();
+}
+
+// Each row is scanned as Cederberg_Spaghetti does as soon as the following one has been pushed, and the
+// last row when the stream is finished, see CederbergSpaghettiRow()
+template <typename ActiveChains>
+void Cederberg_Spaghetti_Stream<ActiveChains>::PushRow(const uint8_t* row) {
+
+	// The oldest row of the window is replaced by the new one
+	rows_[0].swap(rows_[1]);
+	rows_[1].swap(rows_[2]);
+	copy(row, row + w_, rows_[2].begin());
+	n_rows_++;
+
+	if (n_rows_ == 2) {
+		CederbergSpaghettiRow(SpaghettiLine::FIRST, 0, w_, nullptr, rows_[1].data(), rows_[2].data(), rccode_, chains_);
+	}
+	else if (n_rows_ > 2) {
+		CederbergSpaghettiRow(SpaghettiLine::CENTER, n_rows_ - 2, w_, rows_[0].data(), rows_[1].data(), rows_[2].data(), rccode_, chains_);
+	}
+}
+
+template <typename ActiveChains>
+void Cederberg_Spaghetti_Stream<ActiveChains>::FinishStream() {
+
+	if (n_rows_ == 1) {
+		CederbergSpaghettiRow(SpaghettiLine::SINGLE, 0, w_, nullptr, rows_[2].data(), nullptr, rccode_, chains_);
+	}
+	else if (n_rows_ > 1) {
+		CederbergSpaghettiRow(SpaghettiLine::LAST, n_rows_ - 1, w_, rows_[1].data(), rows_[2].data(), nullptr, rccode_, chains_);
+	}
+
+	StoreContours(rccode_);
+	{
+		RCCode finished(std::move(rccode_));  // gives its storage back to the workspace
+	}
+}
+
+template <typename ActiveChains>
+void Cederberg_Spaghetti_Stream<ActiveChains>::PerformChainCode() {
+
+	StartStream(img_.cols);
+	for (int r = 0; r < img_.rows; r++) {
+		PushRow(img_.ptr(r));
+	}
+	FinishStream();
 }
 
 
-void Cederberg_Spaghetti_FREQ_All::PerformChainCode() {
+template <typename ActiveChains>
+void Cederberg_Spaghetti_FREQ_All<ActiveChains>::PerformChainCode() {
 
-	RCCode rccode;
+	RCCode rccode(workspace_, contour_sink_);
 
 	int w = img_.cols;
 	int h = img_.rows;
 
-	vector<unsigned> chains;
+	ActiveChains chains;
 
 	const unsigned char* previous_row_ptr = nullptr;
 	const unsigned char* row_ptr = img_.ptr(0);
@@ -1616,18 +2346,19 @@ void Cederberg_Spaghetti_FREQ_All::PerformChainCode() {
 #undef CONDITION_H
 
 
-    RCCodeToChainCode(rccode, chain_code_);
+    StoreContours(rccode);
 }
 
 
-void Cederberg_Tree::PerformChainCode() {
+template <typename ActiveChains>
+void Cederberg_Tree<ActiveChains>::PerformChainCode() {
 
-	RCCode rccode;
+	RCCode rccode(workspace_, contour_sink_);
 
 	int w = img_.cols;
 	int h = img_.rows;
 
-	vector<unsigned> chains;
+	ActiveChains chains;
 
 	const unsigned char* previous_row_ptr = nullptr;
 	const unsigned char* row_ptr = img_.ptr(0);
@@ -1801,18 +2532,19 @@ void Cederberg_Tree::PerformChainCode() {
 #undef CONDITION_H
     }
 
-    RCCodeToChainCode(rccode, chain_code_);
+    StoreContours(rccode);
 }
 
 
-void Cederberg_Spaghetti_FREQ_AllNoClassical::PerformChainCode() {
+template <typename ActiveChains>
+void Cederberg_Spaghetti_FREQ_AllNoClassical<ActiveChains>::PerformChainCode() {
 
-	RCCode rccode;
+	RCCode rccode(workspace_, contour_sink_);
 
 	int w = img_.cols;
 	int h = img_.rows;
 
-	vector<unsigned> chains;
+	ActiveChains chains;
 
 	const unsigned char* previous_row_ptr = nullptr;
 	const unsigned char* row_ptr = img_.ptr(0);
@@ -2024,18 +2756,19 @@ void Cederberg_Spaghetti_FREQ_AllNoClassical::PerformChainCode() {
 #undef CONDITION_H
 
 
-    RCCodeToChainCode(rccode, chain_code_);
+    StoreContours(rccode);
 }
 
 
-void Cederberg_Spaghetti_FREQ_Hamlet::PerformChainCode() {
+template <typename ActiveChains>
+void Cederberg_Spaghetti_FREQ_Hamlet<ActiveChains>::PerformChainCode() {
 
-	RCCode rccode;
+	RCCode rccode(workspace_, contour_sink_);
 
 	int w = img_.cols;
 	int h = img_.rows;
 
-	vector<unsigned> chains;
+	ActiveChains chains;
 
 	const unsigned char* previous_row_ptr = nullptr;
 	const unsigned char* row_ptr = img_.ptr(0);
@@ -2248,7 +2981,136 @@ void Cederberg_Spaghetti_FREQ_Hamlet::PerformChainCode() {
 #undef CONDITION_H
 
 
-    RCCodeToChainCode(rccode, chain_code_);
+    StoreContours(rccode);
+}
+
+template <typename ActiveChains>
+void Cederberg_Topology<ActiveChains>::PerformChainCode() {
+
+    with_hierarchy_ = true;
+
+    RCCodeTopology rccode(workspace_);
+
+    ActiveChains chains;
+
+    int h = img_.rows;
+    int w = img_.cols;
+
+    const unsigned char* previous_row_ptr = nullptr;
+    const unsigned char* row_ptr = img_.ptr(0);
+    const unsigned char* next_row_ptr = row_ptr + img_.step[0];
+
+    // Build Raster Scan Chain Code
+    for (int r = 0; r < h; r++) {
+        unsigned int pos = 0;
+
+        for (int c = 0; c < w; c++) {
+
+            unsigned short condition = 0;
+
+            if (r > 0 && c > 0 && previous_row_ptr[c - 1])               condition |= PIXEL_A;
+            if (r > 0 && previous_row_ptr[c])                            condition |= PIXEL_B;
+            if (r > 0 && c + 1 < w && previous_row_ptr[c + 1])           condition |= PIXEL_C;
+            if (c > 0 && row_ptr[c - 1])                                 condition |= PIXEL_D;
+            if (row_ptr[c])                                              condition |= PIXEL_X;
+            if (c + 1 < w && row_ptr[c + 1])                             condition |= PIXEL_E;
+            if (r + 1 < h && c > 0 && next_row_ptr[c - 1])               condition |= PIXEL_F;
+            if (r + 1 < h && next_row_ptr[c])                            condition |= PIXEL_G;
+            if (r + 1 < h && c + 1 < w && next_row_ptr[c + 1])           condition |= PIXEL_H;
+
+            unsigned short state = TemplateCheck::CheckState(condition);
+
+            pos = ProcessPixelNaive(r, c, state, rccode, chains, pos);
+        }
+
+        previous_row_ptr = row_ptr;
+        row_ptr = next_row_ptr;
+        next_row_ptr += img_.step[0];
+    }
+
+    StoreContours(rccode);
+}
+
+template <typename ActiveChains>
+void Cederberg_Topology_LUT<ActiveChains>::PerformChainCode() {
+
+    with_hierarchy_ = true;
+
+    RCCodeTopology rccode(workspace_);
+
+    {
+        // The table of cederberg_lut.inc is declared on RCCode
+        using RCCode = RCCodeTopology;
+
+#include "cederberg_lut.inc"
+
+        ActiveChains chains;
+
+        const unsigned char* previous_row_ptr = nullptr;
+        const unsigned char* row_ptr = img_.ptr(0);
+        const unsigned char* next_row_ptr = row_ptr + img_.step[0];
+
+        // Build Raster Scan Chain Code
+        for (int r = 0; r < img_.rows; r++) {
+            unsigned int pos = 0;
+
+            for (int c = 0; c < img_.cols; c++) {
+
+                unsigned short condition = 0;
+
+                if (r > 0 && c > 0 && previous_row_ptr[c - 1])                      condition |= PIXEL_A;
+                if (r > 0 && previous_row_ptr[c])                                   condition |= PIXEL_B;
+                if (r > 0 && c + 1 < img_.cols && previous_row_ptr[c + 1])           condition |= PIXEL_C;
+                if (c > 0 && row_ptr[c - 1])                                        condition |= PIXEL_D;
+                if (row_ptr[c])                                                     condition |= PIXEL_X;
+                if (c + 1 < img_.cols && row_ptr[c + 1])                             condition |= PIXEL_E;
+                if (r + 1 < img_.rows && c > 0 && next_row_ptr[c - 1])               condition |= PIXEL_F;
+                if (r + 1 < img_.rows && next_row_ptr[c])                            condition |= PIXEL_G;
+                if (r + 1 < img_.rows && c + 1 < img_.cols && next_row_ptr[c + 1])    condition |= PIXEL_H;
+
+                pos = table[condition](r, c, rccode, chains, pos);
+            }
+
+            previous_row_ptr = row_ptr;
+            row_ptr = next_row_ptr;
+            next_row_ptr += img_.step[0];
+        }
+    }
+
+    StoreContours(rccode);
+}
+
+template <typename ActiveChains>
+RCCodeTopology Cederberg_Topology_Spaghetti<ActiveChains>::PerformRCCode() {
+
+	RCCodeTopology rccode(workspace_);
+
+	CederbergSpaghettiScan<ActiveChains>(img_, rccode);
+
+	return rccode;
+}
+
+template <typename ActiveChains>
+void Cederberg_Topology_Spaghetti<ActiveChains>::PerformChainCode() {
+	with_hierarchy_ = true;
+	RCCodeTopology rccode = PerformRCCode();
+	StoreContours(rccode);
+}
+
+template <typename ActiveChains>
+void Cederberg_Topology_Spaghetti<ActiveChains>::PerformChainCodeWithSteps() {
+
+	with_hierarchy_ = true;
+
+	perf_.start();
+	RCCodeTopology rccode = PerformRCCode();
+	perf_.stop();
+	perf_.store(Step(StepType::ALGORITHM), perf_.last());
+
+	perf_.start();
+	StoreContours(rccode);
+	perf_.stop();
+	perf_.store(Step(StepType::CONVERSION), perf_.last());
 }
 
 
@@ -2276,12 +3138,34 @@ void Cederberg_Spaghetti_FREQ_Hamlet::PerformChainCode() {
 #undef PIXEL_G
 #undef PIXEL_H
 
-REGISTER_CHAINCODEALG(Cederberg)
-REGISTER_CHAINCODEALG(Cederberg_LUT)
-REGISTER_CHAINCODEALG(Cederberg_LUT_PRED)
-REGISTER_CHAINCODEALG(Cederberg_DRAG)
-REGISTER_CHAINCODEALG(Cederberg_Tree)
-REGISTER_CHAINCODEALG(Cederberg_Spaghetti)
-REGISTER_CHAINCODEALG(Cederberg_Spaghetti_FREQ_All)
-REGISTER_CHAINCODEALG(Cederberg_Spaghetti_FREQ_AllNoClassical)
-REGISTER_CHAINCODEALG(Cederberg_Spaghetti_FREQ_Hamlet)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_LUT)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_LUT_PRED)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Padded)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_LUT_Padded)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Packed)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_EdgeMask)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_LUT_TwoRows)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_TwoPhase)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_DRAG)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Tree)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Spaghetti)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Spaghetti_MT)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Spaghetti_Stream)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Spaghetti_FREQ_All)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Spaghetti_FREQ_AllNoClassical)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Spaghetti_FREQ_Hamlet)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Topology)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Topology_LUT)
+REGISTER_CHAINCODEALG_CHAINS(Cederberg_Topology_Spaghetti)
+
+REGISTER_CHAINCODEALG_RETRIEVAL(Cederberg_Topology)
+REGISTER_CHAINCODEALG_RETRIEVAL(Cederberg_Topology_LUT)
+REGISTER_CHAINCODEALG_RETRIEVAL(Cederberg_Topology_Spaghetti)
+
+REGISTER_CHAINCODEALG_LAZY(Cederberg_DRAG)
+REGISTER_CHAINCODEALG_LAZY(Cederberg_Spaghetti)
+
+REGISTER_CHAINCODEALG_CHAINCODE(Cederberg_Spaghetti)
+REGISTER_CHAINCODEALG_CHAINCODE(Cederberg_Spaghetti_MT)
+REGISTER_CHAINCODEALG_CHAINCODE(Cederberg_Topology_Spaghetti)
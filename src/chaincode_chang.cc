@@ -61,7 +61,7 @@ void Chang::PerformChainCode() {
 
     n_labels_++; // To count also background label
 
-    chain_code_ = ChainCode(contours, false);
+    StoreContours(contours, false);
 
 }
 
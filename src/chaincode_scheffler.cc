@@ -15,6 +15,7 @@
 
 #include <opencv2/imgproc.hpp>
 
+#include "background_runs.h"
 #include "register.h"
 
 
@@ -232,44 +233,47 @@ void WriteActionAndRules() {
     os << "]\n";
 }
 
-}
-
-void MergeNodes(RCNode* dst, RCNode* src, RCCode& rccode, bool different_status = false) {
-    unsigned int index = src->elem_index;
+// Number of chains which are open when the scan of the line between rows r - 1 and r starts.
+// Every chain still open at the end of a line has been passed by one D1, D2 or D3 link, each
+// MAX_I opens two chains and each MIN_O closes two chains without passing them, so the count
+// only depends on the states of this line.
+unsigned CountIncomingChains(const unsigned char* previous_row_ptr, const unsigned char* row_ptr, int w) {
+
+    static const vector<int8_t> chains_delta = []() {
+        vector<int8_t> lut(64);
+        for (uint8_t condition = 0; condition < 64; condition++) {
+            const uint16_t state = TemplateCheck::CondToState(condition);
+            for (uint16_t links = state & (D1_L | D1_R | D2_L | D2_R | D3_L | D3_R); links; links &= links - 1) {
+                lut[condition]++;
+            }
+            if (state & MAX_I) {
+                lut[condition] -= 2;
+            }
+            if (state & MIN_O) {
+                lut[condition] += 2;
+            }
+        }
+        return lut;
+    }();
 
-    // Update node pointer in src max point
-    rccode[index].node = dst;
+    int count = 0;
+    for (int c = 0; c < w; c++) {
 
-    // Update node pointer in next max points
-    unsigned int next_index = rccode[index].next;
-    while (next_index != index) {
-        index = next_index;
-        rccode[index].node = dst;
-        next_index = rccode[index].next;
-    }
+        uint8_t condition = 0;
 
-    // Update node pointer in prev max points
-    unsigned int prev_index = rccode[index].prev;
-    while (prev_index != index) {
-        index = prev_index;
-        rccode[index].node = dst;
-        prev_index = rccode[index].prev;
-    }
+        if (c > 0 && previous_row_ptr[c - 1])                     condition |= PIXEL_A;
+        if (previous_row_ptr[c])                                  condition |= PIXEL_B;
+        if (c + 1 < w && previous_row_ptr[c + 1])                 condition |= PIXEL_C;
+        if (c > 0 && row_ptr[c - 1])                              condition |= PIXEL_D;
+        if (row_ptr[c])                                           condition |= PIXEL_E;
+        if (c + 1 < w && row_ptr[c + 1])                          condition |= PIXEL_F;
 
-    // Reparent children of src
-    RCNode* new_parent = different_status ? dst->parent : dst;
-    for (auto& child : src->children) {
-        child.get()->parent = new_parent;
+        count += chains_delta[condition];
     }
-    new_parent->children.insert(new_parent->children.end(),
-        make_move_iterator(src->children.begin()),
-        make_move_iterator(src->children.end()));
 
-    // Let's re-add this.
-    // Nodes once again point to the top-left maxpoint in the contour.
-    dst->elem_index = min(dst->elem_index, src->elem_index);
+    return static_cast<unsigned>(count);
+}
 
-    src->parent->DeleteChild(src);
 }
 
 /*
@@ -277,47 +281,46 @@ Connect the two chains preceding pos (pos-1 and pos-2).
 Erases the two connected chains from the list (vector),
 so after this call the outer value of pos may be invalid.
 */
-template <bool outer>
-inline void ConnectChains(RCCode& rccode, vector<unsigned>& chains, unsigned int pos) {
+template <bool outer, typename ActiveChains>
+inline void ConnectChains(RCCode& rccode, ActiveChains& chains, unsigned int pos) {
 
     // outer: first_it is left and second_it is right
     // inner: first_it is right and second_it is left
 
     if (outer) {
-        rccode[chains[pos - 1]].next = chains[pos - 2];
+        rccode.Connect(chains[pos - 1], chains[pos - 2]);
     }
     else {
-        rccode[chains[pos - 2]].next = chains[pos - 1];
+        rccode.Connect(chains[pos - 2], chains[pos - 1]);
     }
 
     // Remove chains from vector
-    chains.erase(chains.begin() + pos - 2, chains.begin() + pos);
+    chains.ErasePair(pos - 2);
 }
 
-template <bool outer>
-inline void ConnectChainsTopology(RCCode& rccode, vector<unsigned>& chains, unsigned int pos,
-    RCNode** object, RCNode** hole) {
+template <bool outer, typename ActiveChains>
+inline void ConnectChainsTopology(RCCodeTopology& rccode, ActiveChains& chains, unsigned int pos,
+    unsigned* object, unsigned* hole) {
 
-    RCNode* current_node = nullptr;
-    RCNode* l = rccode[chains[pos - 2]].node;
-    RCNode* r = rccode[chains[pos - 1]].node;
+    RCNodeTree& tree = rccode.tree;
+    unsigned current_node = RCNode::kNone;
+    const unsigned l = rccode.Node(chains[pos - 2]);
+    const unsigned r = rccode.Node(chains[pos - 1]);
 
     // outer: first_it is left and second_it is right
     // inner: first_it is right and second_it is left
 
     if (outer) {
         rccode[chains[pos - 1]].next = chains[pos - 2];
-        rccode[chains[pos - 2]].prev = chains[pos - 1];
     }
     else {
         rccode[chains[pos - 2]].next = chains[pos - 1];
-        rccode[chains[pos - 1]].prev = chains[pos - 2];
     }
 
     // Remove chains from vector
-    chains.erase(chains.begin() + pos - 2, chains.begin() + pos);
+    chains.ErasePair(pos - 2);
 
-    RCNode* x, * y;
+    unsigned x, y;
     if (outer) {
         y = l;
         x = r;
@@ -328,28 +331,28 @@ inline void ConnectChainsTopology(RCCode& rccode, vector<unsigned>& chains, unsi
     }
 
     if (l == r) {
-        if (l->status == RCNode::Status::potH) {
-            l->status = RCNode::Status::H;
+        if (tree[l].status == RCNode::Status::potH) {
+            tree[l].status = RCNode::Status::H;
         }
         else {
-            l->status = RCNode::Status::O;
+            tree[l].status = RCNode::Status::O;
         }
     }
-    else if (l->status == r->status) {
-        MergeNodes(l, r, rccode, false);
+    else if (tree[l].status == tree[r].status) {
+        tree.Merge(l, r, false);
         current_node = l;
     }
     else {
-        if (l->status == RCNode::Status::potO) {
-            MergeNodes(y, x, rccode, true);
-            current_node = y->parent;
+        if (tree[l].status == RCNode::Status::potO) {
+            tree.Merge(y, x, true);
+            current_node = tree.Parent(y);
         }
         else {
-            MergeNodes(x, y, rccode, true);
-            current_node = x->parent;
+            tree.Merge(x, y, true);
+            current_node = tree.Parent(x);
         }
     }
-    if (current_node != nullptr) {
+    if (current_node != RCNode::kNone) {
         if (outer) {
             *hole = current_node;
         }
@@ -362,8 +365,9 @@ inline void ConnectChainsTopology(RCCode& rccode, vector<unsigned>& chains, unsi
     }
 }
 
+template <typename ActiveChains>
 unsigned int ProcessPixelNaive(int r, int c, uint16_t state, RCCode& rccode,
-    vector<unsigned>& chains, unsigned int pos, bool& chain_is_left) {
+    ActiveChains& chains, unsigned int pos, bool& chain_is_left) {
 
     if (state & D0_L) {
         if (chain_is_left) {
@@ -379,13 +383,13 @@ unsigned int ProcessPixelNaive(int r, int c, uint16_t state, RCCode& rccode,
     }
 
     if (state & MAX_I) {
-        rccode.AddElem(r - 1, c);
+        const unsigned elem = rccode.AddElem(r - 1, c);
         if (chain_is_left) {
-            chains.insert(chains.begin() + pos - 1, 2, static_cast<int>(rccode.Size()) - 1);
+            chains.InsertPair(pos - 1, elem);
             rccode[chains[pos - 1]].right.push_back(rccode[chains[pos + 1]].right.pop_back());
         }
         else {
-            chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
+            chains.InsertPair(pos, elem);
         }
     }
 
@@ -440,8 +444,8 @@ unsigned int ProcessPixelNaive(int r, int c, uint16_t state, RCCode& rccode,
     }
 
     if (state & MAX_O) {
-        rccode.AddElem(r, c);
-        chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
+        const unsigned elem = rccode.AddElem(r, c);
+        chains.InsertPair(pos, elem);
         pos += 2;
     }
 
@@ -449,9 +453,9 @@ unsigned int ProcessPixelNaive(int r, int c, uint16_t state, RCCode& rccode,
 
 }
 
-template <uint16_t state>
+template <uint16_t state, typename ActiveChains>
 unsigned int ProcessPixel(int r, int c, RCCode& rccode,
-    vector<unsigned>& chains, unsigned int pos, bool& chain_is_left) {
+    ActiveChains& chains, unsigned int pos, bool& chain_is_left) {
 
     if (state & D0_L) {
         if (chain_is_left) {
@@ -467,13 +471,13 @@ unsigned int ProcessPixel(int r, int c, RCCode& rccode,
     }
 
     if (state & MAX_I) {
-        rccode.AddElem(r - 1, c);
+        const unsigned elem = rccode.AddElem(r - 1, c);
         if (chain_is_left) {
-            chains.insert(chains.begin() + pos - 1, 2, static_cast<int>(rccode.Size()) - 1);
+            chains.InsertPair(pos - 1, elem);
             rccode[chains[pos - 1]].right.push_back(rccode[chains[pos + 1]].right.pop_back());
         }
         else {
-            chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
+            chains.InsertPair(pos, elem);
         }
     }
 
@@ -528,8 +532,8 @@ unsigned int ProcessPixel(int r, int c, RCCode& rccode,
     }
 
     if (state & MAX_O) {
-        rccode.AddElem(r, c);
-        chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
+        const unsigned elem = rccode.AddElem(r, c);
+        chains.InsertPair(pos, elem);
         pos += 2;
     }
 
@@ -538,29 +542,31 @@ unsigned int ProcessPixel(int r, int c, RCCode& rccode,
 }
 
 
-void AddLinkLeft(RCCode& rccode, vector<unsigned>& chains, unsigned int& pos, bool& chain_is_left,
-    RCNode** object, RCNode** hole, uint8_t link) {
+template <typename ActiveChains>
+void AddLinkLeft(RCCodeTopology& rccode, ActiveChains& chains, unsigned int& pos, bool& chain_is_left,
+    unsigned* object, unsigned* hole, uint8_t link) {
     rccode[chains[pos]].left.push_back(link);
 
-    RCNode* node = rccode[chains[pos]].node;
-    if (node->status == RCNode::Status::potO) {
+    const unsigned node = rccode.Node(chains[pos]);
+    if (rccode.tree[node].status == RCNode::Status::potO) {
         *object = node;
     }
-    else if (node->status == RCNode::Status::potH) {
-        *hole = node->parent->parent;
-        *object = node->parent;
+    else if (rccode.tree[node].status == RCNode::Status::potH) {
+        *object = rccode.tree.Parent(node);
+        *hole = rccode.tree.Parent(*object);
     }
 
     pos++;
     chain_is_left = !chain_is_left;
 }
 
-void AddLinkRight(RCCode& rccode, vector<unsigned>& chains, unsigned int& pos, bool& chain_is_left,
-    RCNode** object, RCNode** hole, uint8_t link) {
+template <typename ActiveChains>
+void AddLinkRight(RCCodeTopology& rccode, ActiveChains& chains, unsigned int& pos, bool& chain_is_left,
+    unsigned* object, unsigned* hole, uint8_t link) {
     rccode[chains[pos]].right.push_back(link);
 
-    RCNode* node = rccode[chains[pos]].node;
-    if (node->status == RCNode::Status::potH) {
+    const unsigned node = rccode.Node(chains[pos]);
+    if (rccode.tree[node].status == RCNode::Status::potH) {
         *hole = node;
     }
 
@@ -568,9 +574,10 @@ void AddLinkRight(RCCode& rccode, vector<unsigned>& chains, unsigned int& pos, b
     chain_is_left = !chain_is_left;
 }
 
-unsigned int ProcessPixelNaiveTopology(int r, int c, uint16_t state, RCCode& rccode,
-    vector<unsigned>& chains, unsigned int pos, bool& chain_is_left,
-    RCNode** object, RCNode** hole) {
+template <typename ActiveChains>
+unsigned int ProcessPixelNaiveTopology(int r, int c, uint16_t state, RCCodeTopology& rccode,
+    ActiveChains& chains, unsigned int pos, bool& chain_is_left,
+    unsigned* object, unsigned* hole) {
 
     if (state & D0_L) {
         if (chain_is_left) {
@@ -586,14 +593,14 @@ unsigned int ProcessPixelNaiveTopology(int r, int c, uint16_t state, RCCode& rcc
     }
 
     if (state & MAX_I) {
-        RCNode* new_node = (*object)->EmplaceChild(static_cast<int>(rccode.Size()), RCNode::Status::potH);
+        const unsigned new_node = rccode.tree.EmplaceChild(*object, static_cast<int>(rccode.Size()), RCNode::Status::potH);
         rccode.AddElem(r - 1, c, new_node);
         if (chain_is_left) {
-            chains.insert(chains.begin() + pos - 1, 2, static_cast<int>(rccode.Size()) - 1);
+            chains.InsertPair(pos - 1, static_cast<unsigned>(rccode.Size()) - 1);
             rccode[chains[pos - 1]].right.push_back(rccode[chains[pos + 1]].right.pop_back());
         }
         else {
-            chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
+            chains.InsertPair(pos, static_cast<unsigned>(rccode.Size()) - 1);
         }
     }
 
@@ -636,10 +643,10 @@ unsigned int ProcessPixelNaiveTopology(int r, int c, uint16_t state, RCCode& rcc
     }
 
     if (state & MAX_O) {
-        RCNode* new_node = (*hole)->EmplaceChild(static_cast<int>(rccode.Size()), RCNode::Status::potO);
+        const unsigned new_node = rccode.tree.EmplaceChild(*hole, static_cast<int>(rccode.Size()), RCNode::Status::potO);
         *object = new_node;
         rccode.AddElem(r, c, new_node);
-        chains.insert(chains.begin() + pos, 2, static_cast<int>(rccode.Size()) - 1);
+        chains.InsertPair(pos, static_cast<unsigned>(rccode.Size()) - 1);
         pos += 2;
     }
 
@@ -647,50 +654,91 @@ unsigned int ProcessPixelNaiveTopology(int r, int c, uint16_t state, RCCode& rcc
 
 }
 
+template <uint16_t state, typename ActiveChains>
+unsigned int ProcessPixel(int r, int c, RCCodeTopology& rccode,
+    ActiveChains& chains, unsigned int pos, bool& chain_is_left,
+    unsigned* object, unsigned* hole) {
 
-void Scheffler::PerformChainCode() {
-
-    RCCode rccode;
-
-    vector<unsigned> chains;
-
-    int h = img_.rows;
-    int w = img_.cols;
-
-    const unsigned char* previous_row_ptr = nullptr;
-    const unsigned char* row_ptr = img_.ptr(0);
-    bool chain_is_left = true;
-
-    // Build Raster Scan Chain Code
-    for (int r = 0; r < h + 1; r++) {
-        unsigned int pos = 0;
-        chain_is_left = true;   // TODO verificare
+    if (state & D0_L) {
+        if (chain_is_left) {
+            rccode[chains[pos]].left.push_back(0);
+        }
+        else {
+            rccode[chains[pos - 1]].left.push_back(0);
+        }
+    }
 
-        for (int c = 0; c < w; c++) {
+    if (state & MIN_O) {
+        ConnectChainsTopology<true>(rccode, chains, pos + 2, object, hole);
+    }
 
-            uint8_t condition = 0;
+    if (state & MAX_I) {
+        const unsigned new_node = rccode.tree.EmplaceChild(*object, static_cast<int>(rccode.Size()), RCNode::Status::potH);
+        rccode.AddElem(r - 1, c, new_node);
+        if (chain_is_left) {
+            chains.InsertPair(pos - 1, static_cast<unsigned>(rccode.Size()) - 1);
+            rccode[chains[pos - 1]].right.push_back(rccode[chains[pos + 1]].right.pop_back());
+        }
+        else {
+            chains.InsertPair(pos, static_cast<unsigned>(rccode.Size()) - 1);
+        }
+    }
 
-            if (r > 0 && c > 0 && previous_row_ptr[c - 1])                     condition |= PIXEL_A;
-            if (r > 0 && previous_row_ptr[c])                                  condition |= PIXEL_B;
-            if (r > 0 && c + 1 < w && previous_row_ptr[c + 1])                 condition |= PIXEL_C;
-            if (r < h && c > 0 && row_ptr[c - 1])                              condition |= PIXEL_D;
-            if (r < h && row_ptr[c])                                           condition |= PIXEL_E;
-            if (r < h && c + 1 < w && row_ptr[c + 1])                          condition |= PIXEL_F;
+    if (state & D0_R) {
+        if (chain_is_left) {
+            rccode[chains[pos - 1]].right.push_back(0);
+        }
+        else {
+            rccode[chains[pos - 2]].right.push_back(0);
+        }
+    }
 
-            uint16_t state = TemplateCheck::CondToState(condition);
+    if (state & D1_L) {
+        AddLinkLeft(rccode, chains, pos, chain_is_left, object, hole, 1);
+    }
+    if (state & D1_R) {
+        AddLinkRight(rccode, chains, pos, chain_is_left, object, hole, 1);
+    }
+    if (state & D2_L) {
+        AddLinkLeft(rccode, chains, pos, chain_is_left, object, hole, 2);
+    }
+    if (state & D2_R) {
+        AddLinkRight(rccode, chains, pos, chain_is_left, object, hole, 2);
+    }
+    if (state & D3_L) {
+        AddLinkLeft(rccode, chains, pos, chain_is_left, object, hole, 3);
+    }
+    if (state & D3_R) {
+        AddLinkRight(rccode, chains, pos, chain_is_left, object, hole, 3);
+    }
 
-            pos = ProcessPixelNaive(r, c, state, rccode, chains, pos, chain_is_left);
+    if (state & MIN_I) {
+        if (chain_is_left) {
+            ConnectChainsTopology<false>(rccode, chains, pos - 1, object, hole);
         }
+        else {
+            ConnectChainsTopology<false>(rccode, chains, pos, object, hole);
+        }
+        pos -= 2;
+    }
 
-        previous_row_ptr = row_ptr;
-        row_ptr += img_.step[0];
+    if (state & MAX_O) {
+        const unsigned new_node = rccode.tree.EmplaceChild(*hole, static_cast<int>(rccode.Size()), RCNode::Status::potO);
+        *object = new_node;
+        rccode.AddElem(r, c, new_node);
+        chains.InsertPair(pos, static_cast<unsigned>(rccode.Size()) - 1);
+        pos += 2;
     }
 
-    RCCodeToChainCode(rccode, chain_code_);
+    return pos;
+
 }
 
+// Raster scans shared by the algorithms with and without topology. Those with topology pass the
+// object and the hole crossed by the scan line as regions, which are forwarded to ProcessPixel.
 
-void Scheffler_LUT::PerformChainCode() {
+template <typename ActiveChains, typename RCCodeType, typename... Regions>
+void SchefflerLUTScan(const Mat1b& img, RCCodeType& rccode, Regions... regions) {
 
     //static const constexpr std::array<uint16_t, 64> StateLUT = {
     //    0, 0, 8, 2056, 0, 0, 0, 2048, 0, 0, 0, 0, 0, 0, 1, 1,
@@ -700,15 +748,13 @@ void Scheffler_LUT::PerformChainCode() {
 
 #include "scheffler_lut.inc"
 
-    RCCode rccode;
-
-    vector<unsigned> chains;
+    ActiveChains chains;
 
-    int h = img_.rows;
-    int w = img_.cols;
+    int h = img.rows;
+    int w = img.cols;
 
     const unsigned char* previous_row_ptr = nullptr;
-    const unsigned char* row_ptr = img_.ptr(0);
+    const unsigned char* row_ptr = img.ptr(0);
     bool chain_is_left = true;
 
     // Build Raster Scan Chain Code
@@ -730,30 +776,26 @@ void Scheffler_LUT::PerformChainCode() {
             //const uint16_t state = StateLUT[condition];
 
             auto processPixelFunction = LUT[condition];
-            pos = processPixelFunction(r, c, rccode, chains, pos, chain_is_left);
+            pos = processPixelFunction(r, c, rccode, chains, pos, chain_is_left, regions...);
         }
 
         previous_row_ptr = row_ptr;
-        row_ptr += img_.step[0];
+        row_ptr += img.step[0];
     }
-
-    RCCodeToChainCode(rccode, chain_code_);
 }
 
-
-void Scheffler_LUT_PRED::PerformChainCode() {
+template <typename ActiveChains, typename RCCodeType, typename... Regions>
+void SchefflerLUTPredScan(const Mat1b& img, RCCodeType& rccode, Regions... regions) {
 
 #include "scheffler_lut.inc"
 
-    RCCode rccode;
-
-    vector<unsigned> chains;
+    ActiveChains chains;
 
-    int h = img_.rows;
-    int w = img_.cols;
+    int h = img.rows;
+    int w = img.cols;
 
     const unsigned char* previous_row_ptr = nullptr;
-    const unsigned char* row_ptr = img_.ptr(0);
+    const unsigned char* row_ptr = img.ptr(0);
     bool chain_is_left = true;
 
     if (h == 1 || w == 1) {
@@ -775,14 +817,13 @@ void Scheffler_LUT_PRED::PerformChainCode() {
                 //const uint16_t state = StateLUT[condition];
 
                 auto processPixelFunction = LUT[condition];
-                pos = processPixelFunction(r, c, rccode, chains, pos, chain_is_left);
+                pos = processPixelFunction(r, c, rccode, chains, pos, chain_is_left, regions...);
             }
 
             previous_row_ptr = row_ptr;
-            row_ptr += img_.step[0];
+            row_ptr += img.step[0];
         }
 
-        RCCodeToChainCode(rccode, chain_code_);
         return;
     }
 
@@ -798,7 +839,7 @@ void Scheffler_LUT_PRED::PerformChainCode() {
         if (row_ptr[1])                  condition |= PIXEL_F;
 
         auto processPixelFunction = LUT[condition];
-        pos = processPixelFunction(0, 0, rccode, chains, pos, chain_is_left);
+        pos = processPixelFunction(0, 0, rccode, chains, pos, chain_is_left, regions...);
 
         for (int c = 1; c < w - 1; c++) {
 
@@ -807,16 +848,16 @@ void Scheffler_LUT_PRED::PerformChainCode() {
             if (row_ptr[c + 1])                          condition |= PIXEL_F;
 
             processPixelFunction = LUT[condition];
-            pos = processPixelFunction(0, c, rccode, chains, pos, chain_is_left);
+            pos = processPixelFunction(0, c, rccode, chains, pos, chain_is_left, regions...);
 
         }
 
         condition = condition >> 1 & ~7;
         processPixelFunction = LUT[condition];
-        pos = processPixelFunction(0, w - 1, rccode, chains, pos, chain_is_left);
+        pos = processPixelFunction(0, w - 1, rccode, chains, pos, chain_is_left, regions...);
 
         previous_row_ptr = row_ptr;
-        row_ptr += img_.step[0];
+        row_ptr += img.step[0];
     }
 
     // Middle Lines
@@ -832,7 +873,7 @@ void Scheffler_LUT_PRED::PerformChainCode() {
         if (row_ptr[1])                     condition |= PIXEL_F;
 
         auto processPixelFunction = LUT[condition];
-        pos = processPixelFunction(r, 0, rccode, chains, pos, chain_is_left);
+        pos = processPixelFunction(r, 0, rccode, chains, pos, chain_is_left, regions...);
 
         for (int c = 1; c < w - 1; c++) {
 
@@ -842,16 +883,16 @@ void Scheffler_LUT_PRED::PerformChainCode() {
             if (row_ptr[c + 1])                         condition |= PIXEL_F;
 
             processPixelFunction = LUT[condition];
-            pos = processPixelFunction(r, c, rccode, chains, pos, chain_is_left);
+            pos = processPixelFunction(r, c, rccode, chains, pos, chain_is_left, regions...);
 
         }
 
         condition = condition >> 1 & ~(PIXEL_C | PIXEL_F);
         processPixelFunction = LUT[condition];
-        pos = processPixelFunction(r, w - 1, rccode, chains, pos, chain_is_left);
+        pos = processPixelFunction(r, w - 1, rccode, chains, pos, chain_is_left, regions...);
 
         previous_row_ptr = row_ptr;
-        row_ptr += img_.step[0];
+        row_ptr += img.step[0];
     }
 
     // Last line
@@ -864,7 +905,7 @@ void Scheffler_LUT_PRED::PerformChainCode() {
         if (previous_row_ptr[1])            condition |= PIXEL_C;
 
         auto processPixelFunction = LUT[condition];
-        pos = processPixelFunction(0, h, rccode, chains, pos, chain_is_left);
+        pos = processPixelFunction(0, h, rccode, chains, pos, chain_is_left, regions...);
 
         for (int c = 1; c < w - 1; c++) {
 
@@ -873,78 +914,69 @@ void Scheffler_LUT_PRED::PerformChainCode() {
             if (previous_row_ptr[c + 1])            condition |= PIXEL_C;
 
             processPixelFunction = LUT[condition];
-            pos = processPixelFunction(h, c, rccode, chains, pos, chain_is_left);
+            pos = processPixelFunction(h, c, rccode, chains, pos, chain_is_left, regions...);
 
         }
 
         condition = condition >> 1;
         processPixelFunction = LUT[condition];
-        pos = processPixelFunction(h, w - 1, rccode, chains, pos, chain_is_left);
+        pos = processPixelFunction(h, w - 1, rccode, chains, pos, chain_is_left, regions...);
     }
-
-    RCCodeToChainCode(rccode, chain_code_);
 }
 
+template <typename ActiveChains, typename RCCodeType, typename... Regions>
+void SchefflerPackedScan(const BitImage& img, RCCodeType& rccode, Regions... regions) {
 
-void SchefflerTopology::PerformChainCode() {
-
-    with_hierarchy_ = true;
-
-    RCCode rccode(true);
-
-    vector<unsigned> chains;
-
-    int h = img_.rows;
-    int w = img_.cols;
+#include "scheffler_lut.inc"
 
-    const unsigned char* previous_row_ptr = nullptr;
-    const unsigned char* row_ptr = img_.ptr(0);
-    bool chain_is_left = true;
+    ActiveChains chains;
 
-    RCNode* object = nullptr;
-    RCNode* hole = rccode.root.get();
+    const int h = img.rows;
+    const int w = img.cols;
 
-    // Build Raster Scan Chain Code
+    // Build Raster Scan Chain Code, also below the last row
     for (int r = 0; r < h + 1; r++) {
         unsigned int pos = 0;
-        chain_is_left = true;
+        bool chain_is_left = true;
+
+        // Rows outside the image and columns -1 and w are background
+        const uint64_t* previous_row = img.Row(r - 1);
+        const uint64_t* row = img.Row(r);
+
+        // Condition of column -1, whose right neighbors are in column 0
+        uint8_t condition = 0;
+        condition |= BitImage::Pixel(previous_row, 0) * PIXEL_C;
+        condition |= BitImage::Pixel(row, 0) * PIXEL_F;
 
         for (int c = 0; c < w; c++) {
 
-            uint8_t condition = 0;
+            condition = condition >> 1 & ~(PIXEL_C | PIXEL_F);
 
-            if (r > 0 && c > 0 && previous_row_ptr[c - 1])                     condition |= PIXEL_A;
-            if (r > 0 && previous_row_ptr[c])                                  condition |= PIXEL_B;
-            if (r > 0 && c + 1 < w && previous_row_ptr[c + 1])                 condition |= PIXEL_C;
-            if (r < h && c > 0 && row_ptr[c - 1])                              condition |= PIXEL_D;
-            if (r < h && row_ptr[c])                                           condition |= PIXEL_E;
-            if (r < h && c + 1 < w && row_ptr[c + 1])                          condition |= PIXEL_F;
+            condition |= BitImage::Pixel(previous_row, c + 1) * PIXEL_C;
+            condition |= BitImage::Pixel(row, c + 1) * PIXEL_F;
 
-            uint16_t state = TemplateCheck::CondToState(condition);
+            if (condition == 0) {
+                // Background pixels whose neighborhood is background as well do nothing: the
+                // scan goes on from the column before the next foreground one
+                c = std::max(c, img.NextForegroundColumn(c + 2, previous_row, row) - 2);
+                continue;
+            }
 
-            pos = ProcessPixelNaiveTopology(r, c, state, rccode, chains, pos, chain_is_left, &object, &hole);
+            pos = LUT[condition](r, c, rccode, chains, pos, chain_is_left, regions...);
         }
-
-        previous_row_ptr = row_ptr;
-        row_ptr += img_.step[0];
     }
-
-    RCCodeToChainCode(rccode, chain_code_, hierarchy_);
-
 }
 
+// Lines of the image told apart by the Spaghetti forests, the one below the image included
+enum class SchefflerSpaghettiLine { FIRST, CENTER, BELOW };
 
-void Scheffler_Spaghetti::PerformChainCode() {
-
-    RCCode rccode;
+// Step r of the raster scan of Scheffler_Spaghetti, which looks at rows r - 1 and r, going on with the
+// chains of the steps before it. The rows which are not in the image, according to line, are not looked
+// at and may be nullptr. Shared by the serial, strip and stream algorithms, with and without topology.
+template <typename ActiveChains, typename RCCodeType, typename... Regions>
+void SchefflerSpaghettiRow(SchefflerSpaghettiLine line, int r, int w, const unsigned char* previous_row_ptr,
+    const unsigned char* row_ptr, RCCodeType& rccode, ActiveChains& chains, Regions... regions) {
 
-    vector<unsigned> chains;
-
-    int h = img_.rows;
-    int w = img_.cols;
-
-    const unsigned char* previous_row_ptr = nullptr;
-    const unsigned char* row_ptr = img_.ptr(0);
     bool chain_is_left = true;
 
 #define CONDITION_A     (previous_row_ptr[c - 1])                     
@@ -954,67 +986,62 @@ void Scheffler_Spaghetti::PerformChainCode() {
 #define CONDITION_X     (row_ptr[c])                                                    
 #define CONDITION_E     (row_ptr[c + 1])                           
 
-#define ACTION_1	pos = ProcessPixel<0	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_2	pos = ProcessPixel<1	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_3	pos = ProcessPixel<2	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_4	pos = ProcessPixel<8	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_5	pos = ProcessPixel<16	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_6	pos = ProcessPixel<32	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_7	pos = ProcessPixel<48	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_8	pos = ProcessPixel<64	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_9	pos = ProcessPixel<128	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_10	pos = ProcessPixel<144	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_11	pos = ProcessPixel<192	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_12	pos = ProcessPixel<256	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_13	pos = ProcessPixel<292	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_14	pos = ProcessPixel<308	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_15	pos = ProcessPixel<512	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_16	pos = ProcessPixel<528	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_17	pos = ProcessPixel<576	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_18	pos = ProcessPixel<768	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_19	pos = ProcessPixel<804	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_20	pos = ProcessPixel<820	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_21	pos = ProcessPixel<1024	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_22	pos = ProcessPixel<1060	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_23	pos = ProcessPixel<1076	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_24	pos = ProcessPixel<2048	>(r, c, rccode, chains, pos, chain_is_left);
-#define ACTION_25	pos = ProcessPixel<2056	>(r, c, rccode, chains, pos, chain_is_left);
-
-    // First line
-    int r = 0;
+    // After a background pixel the scan jumps over the rest of the background run, looking at the
+    // rows of the window of each line, see SkipBackground()
+#define ACTION_1	pos = ProcessPixel<0	>(r, c, rccode, chains, pos, chain_is_left, regions...); BACKGROUND_RUN
+#define ACTION_2	pos = ProcessPixel<1	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_3	pos = ProcessPixel<2	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_4	pos = ProcessPixel<8	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_5	pos = ProcessPixel<16	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_6	pos = ProcessPixel<32	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_7	pos = ProcessPixel<48	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_8	pos = ProcessPixel<64	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_9	pos = ProcessPixel<128	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_10	pos = ProcessPixel<144	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_11	pos = ProcessPixel<192	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_12	pos = ProcessPixel<256	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_13	pos = ProcessPixel<292	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_14	pos = ProcessPixel<308	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_15	pos = ProcessPixel<512	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_16	pos = ProcessPixel<528	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_17	pos = ProcessPixel<576	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_18	pos = ProcessPixel<768	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_19	pos = ProcessPixel<804	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_20	pos = ProcessPixel<820	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_21	pos = ProcessPixel<1024	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_22	pos = ProcessPixel<1060	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_23	pos = ProcessPixel<1076	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_24	pos = ProcessPixel<2048	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+#define ACTION_25	pos = ProcessPixel<2056	>(r, c, rccode, chains, pos, chain_is_left, regions...);
+
     int c = -1;
     unsigned int pos = 0;
 
-    c = -1;
-    goto fl_tree_0;
+    if (line == SchefflerSpaghettiLine::FIRST) {
+        goto fl_tree_0;
 
+#define BACKGROUND_RUN c = SkipBackground(c, w, row_ptr);
 #include "Scheffler_Spaghetti_first_line_forest_code.inc.h"
+#undef BACKGROUND_RUN
 
-    if (h > 1) {
-        // Build Raster Scan Chain Code
-        for (r = 1; r < h; r++) {
-            chain_is_left = true;   // TODO verify this
-
-            previous_row_ptr = row_ptr;
-            row_ptr += img_.step[0];
-            pos = 0;
-
-            c = -1;
+    }
+    else if (line == SchefflerSpaghettiLine::CENTER) {
+        // The center line forest ends every row with a continue
+        do {
             goto cl_tree_0;
 
+#define BACKGROUND_RUN c = SkipBackground(c, w, previous_row_ptr, row_ptr);
 #include "Scheffler_Spaghetti_center_line_forest_code.inc.h"
+#undef BACKGROUND_RUN
 
-        }
-
-        chain_is_left = true;   // TODO verify this
-        previous_row_ptr = row_ptr;
-        row_ptr = nullptr;
-        pos = 0;
-
-        c = -1;
+        } while (false);
+    }
+    else {
         goto bl_tree_0;
 
+#define BACKGROUND_RUN c = SkipBackground(c, w, previous_row_ptr);
 #include "Scheffler_Spaghetti_below_line_forest_code.inc.h"
+#undef BACKGROUND_RUN
 
     }
 
@@ -1050,10 +1077,418 @@ void Scheffler_Spaghetti::PerformChainCode() {
 #undef CONDITION_D
 #undef CONDITION_X
 #undef CONDITION_E
+}
+
+// Raster scan of Scheffler_Spaghetti on steps [r_begin, r_end), going on with the chains already in
+// chains. Step h is the one below the last row of the image.
+template <typename ActiveChains, typename RCCodeType, typename... Regions>
+void SchefflerSpaghettiScan(const Mat1b& img, int r_begin, int r_end, RCCodeType& rccode, ActiveChains& chains, Regions... regions) {
+
+    const int h = img.rows;
+
+    for (int r = r_begin; r < r_end; r++) {
+
+        SchefflerSpaghettiLine line = SchefflerSpaghettiLine::CENTER;
+        if (r == 0) {
+            line = SchefflerSpaghettiLine::FIRST;
+        }
+        else if (r == h) {
+            line = SchefflerSpaghettiLine::BELOW;
+        }
 
-    RCCodeToChainCode(rccode, chain_code_);
+        const unsigned char* previous_row_ptr = (r > 0) ? img.ptr(r - 1) : nullptr;
+        const unsigned char* row_ptr = (r < h) ? img.ptr(r) : nullptr;
+
+        SchefflerSpaghettiRow(line, r, img.cols, previous_row_ptr, row_ptr, rccode, chains, regions...);
+    }
+}
+
+// Raster scan of Scheffler_Spaghetti on the whole image, also below the last row
+template <typename ActiveChains, typename RCCodeType, typename... Regions>
+void SchefflerSpaghettiScan(const Mat1b& img, RCCodeType& rccode, Regions... regions) {
+    ActiveChains chains;
+    SchefflerSpaghettiScan(img, 0, img.rows + 1, rccode, chains, regions...);
 }
 
+template <typename ActiveChains>
+void Scheffler<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+    ActiveChains chains;
+
+    int h = img_.rows;
+    int w = img_.cols;
+
+    const unsigned char* previous_row_ptr = nullptr;
+    const unsigned char* row_ptr = img_.ptr(0);
+    bool chain_is_left = true;
+
+    // Build Raster Scan Chain Code
+    for (int r = 0; r < h + 1; r++) {
+        unsigned int pos = 0;
+        chain_is_left = true;   // TODO verificare
+
+        for (int c = 0; c < w; c++) {
+
+            uint8_t condition = 0;
+
+            if (r > 0 && c > 0 && previous_row_ptr[c - 1])                     condition |= PIXEL_A;
+            if (r > 0 && previous_row_ptr[c])                                  condition |= PIXEL_B;
+            if (r > 0 && c + 1 < w && previous_row_ptr[c + 1])                 condition |= PIXEL_C;
+            if (r < h && c > 0 && row_ptr[c - 1])                              condition |= PIXEL_D;
+            if (r < h && row_ptr[c])                                           condition |= PIXEL_E;
+            if (r < h && c + 1 < w && row_ptr[c + 1])                          condition |= PIXEL_F;
+
+            uint16_t state = TemplateCheck::CondToState(condition);
+
+            pos = ProcessPixelNaive(r, c, state, rccode, chains, pos, chain_is_left);
+        }
+
+        previous_row_ptr = row_ptr;
+        row_ptr += img_.step[0];
+    }
+
+    StoreContours(rccode);
+}
+
+
+template <typename ActiveChains>
+void Scheffler_LUT<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+    SchefflerLUTScan<ActiveChains>(img_, rccode);
+
+    StoreContours(rccode);
+}
+
+
+template <typename ActiveChains>
+void Scheffler_LUT_PRED<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+    SchefflerLUTPredScan<ActiveChains>(img_, rccode);
+
+    StoreContours(rccode);
+}
+
+
+template <typename ActiveChains>
+void Scheffler_Packed<ActiveChains>::PerformChainCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+    packed_img_.Pack(img_);
+    SchefflerPackedScan<ActiveChains>(packed_img_, rccode);
+
+    StoreContours(rccode);
+}
+
+
+template <typename ActiveChains>
+void SchefflerTopology<ActiveChains>::PerformChainCode() {
+
+    with_hierarchy_ = true;
+
+    RCCodeTopology rccode(workspace_);
+
+    ActiveChains chains;
+
+    int h = img_.rows;
+    int w = img_.cols;
+
+    const unsigned char* previous_row_ptr = nullptr;
+    const unsigned char* row_ptr = img_.ptr(0);
+    bool chain_is_left = true;
+
+    unsigned object = RCNode::kNone;
+    unsigned hole = RCNodeTree::kRoot;
+
+    // Build Raster Scan Chain Code
+    for (int r = 0; r < h + 1; r++) {
+        unsigned int pos = 0;
+        chain_is_left = true;
+
+        for (int c = 0; c < w; c++) {
+
+            uint8_t condition = 0;
+
+            if (r > 0 && c > 0 && previous_row_ptr[c - 1])                     condition |= PIXEL_A;
+            if (r > 0 && previous_row_ptr[c])                                  condition |= PIXEL_B;
+            if (r > 0 && c + 1 < w && previous_row_ptr[c + 1])                 condition |= PIXEL_C;
+            if (r < h && c > 0 && row_ptr[c - 1])                              condition |= PIXEL_D;
+            if (r < h && row_ptr[c])                                           condition |= PIXEL_E;
+            if (r < h && c + 1 < w && row_ptr[c + 1])                          condition |= PIXEL_F;
+
+            uint16_t state = TemplateCheck::CondToState(condition);
+
+            pos = ProcessPixelNaiveTopology(r, c, state, rccode, chains, pos, chain_is_left, &object, &hole);
+        }
+
+        previous_row_ptr = row_ptr;
+        row_ptr += img_.step[0];
+    }
+
+    StoreContours(rccode);
+
+}
+
+template <typename ActiveChains>
+void SchefflerTopology_Padded<ActiveChains>::PerformChainCode() {
+
+    with_hierarchy_ = true;
+
+    RCCodeTopology rccode(workspace_);
+
+    ActiveChains chains;
+
+    padded_img_.Pad(img_);
+
+    bool chain_is_left = true;
+
+    unsigned object = RCNode::kNone;
+    unsigned hole = RCNodeTree::kRoot;
+
+    // Build Raster Scan Chain Code, up to the background row below the image
+    for (int r = 0; r < padded_img_.rows + 1; r++) {
+        unsigned int pos = 0;
+        chain_is_left = true;
+
+        const uint8_t* previous_row_ptr = padded_img_.Row(r - 1);
+        const uint8_t* row_ptr = padded_img_.Row(r);
+
+        for (int c = 0; c < padded_img_.cols; c++) {
+
+            uint8_t condition = 0;
+
+            if (previous_row_ptr[c - 1])    condition |= PIXEL_A;
+            if (previous_row_ptr[c])        condition |= PIXEL_B;
+            if (previous_row_ptr[c + 1])    condition |= PIXEL_C;
+            if (row_ptr[c - 1])             condition |= PIXEL_D;
+            if (row_ptr[c])                 condition |= PIXEL_E;
+            if (row_ptr[c + 1])             condition |= PIXEL_F;
+
+            uint16_t state = TemplateCheck::CondToState(condition);
+
+            pos = ProcessPixelNaiveTopology(r, c, state, rccode, chains, pos, chain_is_left, &object, &hole);
+        }
+    }
+
+    StoreContours(rccode);
+
+}
+
+template <typename ActiveChains>
+void SchefflerTopology_LUT<ActiveChains>::PerformChainCode() {
+
+    with_hierarchy_ = true;
+
+    RCCodeTopology rccode(workspace_);
+
+    unsigned object = RCNode::kNone;
+    unsigned hole = RCNodeTree::kRoot;
+
+    SchefflerLUTScan<ActiveChains>(img_, rccode, &object, &hole);
+
+    StoreContours(rccode);
+}
+
+
+template <typename ActiveChains>
+void SchefflerTopology_LUT_PRED<ActiveChains>::PerformChainCode() {
+
+    with_hierarchy_ = true;
+
+    RCCodeTopology rccode(workspace_);
+
+    unsigned object = RCNode::kNone;
+    unsigned hole = RCNodeTree::kRoot;
+
+    SchefflerLUTPredScan<ActiveChains>(img_, rccode, &object, &hole);
+
+    StoreContours(rccode);
+}
+
+
+template <typename ActiveChains>
+RCCodeTopology SchefflerTopology_Spaghetti<ActiveChains>::PerformRCCode() {
+
+    RCCodeTopology rccode(workspace_);
+
+    unsigned object = RCNode::kNone;
+    unsigned hole = RCNodeTree::kRoot;
+
+    SchefflerSpaghettiScan<ActiveChains>(img_, rccode, &object, &hole);
+
+    return rccode;
+}
+
+template <typename ActiveChains>
+void SchefflerTopology_Spaghetti<ActiveChains>::PerformChainCode() {
+    with_hierarchy_ = true;
+    RCCodeTopology rccode = PerformRCCode();
+    StoreContours(rccode);
+}
+
+template <typename ActiveChains>
+void SchefflerTopology_Spaghetti<ActiveChains>::PerformChainCodeWithSteps() {
+
+    with_hierarchy_ = true;
+
+    perf_.start();
+    RCCodeTopology rccode = PerformRCCode();
+    perf_.stop();
+    perf_.store(Step(StepType::ALGORITHM), perf_.last());
+
+    perf_.start();
+    StoreContours(rccode);
+    perf_.stop();
+    perf_.store(Step(StepType::CONVERSION), perf_.last());
+}
+
+
+template <typename ActiveChains>
+void Scheffler_Spaghetti<ActiveChains>::PerformChainCode() {
+    RCCode rccode = PerformRCCode();
+    StoreContours(rccode);
+}
+
+template <typename ActiveChains>
+void Scheffler_Spaghetti<ActiveChains>::PerformChainCodeWithSteps() {
+
+    perf_.start();
+    RCCode rccode = PerformRCCode();
+    perf_.stop();
+    perf_.store(Step(StepType::ALGORITHM), perf_.last());
+
+    perf_.start();
+    StoreContours(rccode);
+    perf_.stop();
+    perf_.store(Step(StepType::CONVERSION), perf_.last());
+}
+
+template <typename ActiveChains>
+RCCode Scheffler_Spaghetti<ActiveChains>::PerformRCCode() {
+
+    RCCode rccode(workspace_, contour_sink_);
+
+    SchefflerSpaghettiScan<ActiveChains>(img_, rccode);
+
+    return rccode;
+}
+
+
+template <typename ActiveChains>
+void Scheffler_Spaghetti_MT<ActiveChains>::PerformChainCode() {
+
+    int h = img_.rows;
+
+    // Rows are split among strips, the last one also processes the line below the image
+    const unsigned n_strips = max(1u, min(n_threads_, static_cast<unsigned>(h)));
+
+    vector<int> strip_begin(n_strips + 1);
+    for (unsigned s = 0; s < n_strips; s++) {
+        strip_begin[s] = static_cast<int>(static_cast<int64_t>(h) * s / n_strips);
+    }
+    strip_begin[n_strips] = h + 1;
+
+    // The storage kept by the workspace is shared among the strips, and the strips not used anymore
+    // are released
+    strips_.resize(n_strips);
+    for (RCCode& strip : strips_) {
+        strip.Recycle(workspace_.max_retained_elems / n_strips, workspace_.max_retained_chain_words / n_strips);
+    }
+    vector<unsigned> incoming_chains(n_strips, 0);
+    vector<vector<unsigned>> outgoing_chains(n_strips);
+
+    ParallelFor(n_strips, n_threads_, [&](unsigned s) {
+
+        const int r_begin = strip_begin[s];
+
+        // Chains coming from the previous strip are continued by placeholder elems, which
+        // take the same positions in the active chains vector
+        if (r_begin > 0) {
+            incoming_chains[s] = CountIncomingChains(img_.ptr(r_begin - 1), img_.ptr(r_begin), img_.cols);
+        }
+        for (unsigned i = 0; i < incoming_chains[s]; i++) {
+            strips_[s].AddElem(r_begin, 0);
+        }
+
+        vector<unsigned> placeholders(incoming_chains[s]);
+        iota(placeholders.begin(), placeholders.end(), 0);
+
+        ActiveChains chains(move(placeholders));
+        SchefflerSpaghettiScan(img_, r_begin, strip_begin[s + 1], strips_[s], chains);
+
+        outgoing_chains[s] = chains.Values();
+    });
+
+    RCCode rccode(workspace_);
+    MergeRCCodeStrips(strips_, incoming_chains, outgoing_chains, rccode);
+
+    StoreContours(rccode, n_threads_);
+}
+
+
+template <typename ActiveChains>
+void Scheffler_Spaghetti_Stream<ActiveChains>::StartStream(unsigned width) {
+    w_ = static_cast<int>(width);
+    n_rows_ = 0;
+    for (auto& row : rows_) {
+        row.assign(width, 0);
+    }
+    // The output of the previous stream, which may hold an RCCode too, is released first
+    FreeChainCodeData();
+    {
+        // An unfinished stream gives its storage back first, so that the new RCCode takes it
+        RCCode previous(std::move(rccode_));
+    }
+    rccode_ = RCCode(workspace_, contour_sink_);
+    chains_ = ActiveChains();
+}
+
+// Step r of the scan of Scheffler_Spaghetti looks at rows r - 1 and r, so it is performed as soon as row r
+// is pushed, and the step below the image when the stream is finished, see SchefflerSpaghettiRow()
+template <typename ActiveChains>
+void Scheffler_Spaghetti_Stream<ActiveChains>::PushRow(const uint8_t* row) {
+
+    // The oldest row of the window is replaced by the new one
+    rows_[0].swap(rows_[1]);
+    copy(row, row + w_, rows_[1].begin());
+
+    if (n_rows_ == 0) {
+        SchefflerSpaghettiRow(SchefflerSpaghettiLine::FIRST, 0, w_, nullptr, rows_[1].data(), rccode_, chains_);
+    }
+    else {
+        SchefflerSpaghettiRow(SchefflerSpaghettiLine::CENTER, n_rows_, w_, rows_[0].data(), rows_[1].data(), rccode_, chains_);
+    }
+    n_rows_++;
+}
+
+template <typename ActiveChains>
+void Scheffler_Spaghetti_Stream<ActiveChains>::FinishStream() {
+
+    if (n_rows_ > 0) {
+        SchefflerSpaghettiRow(SchefflerSpaghettiLine::BELOW, n_rows_, w_, rows_[1].data(), nullptr, rccode_, chains_);
+    }
+
+    StoreContours(rccode_);
+    {
+        RCCode finished(std::move(rccode_));  // gives its storage back to the workspace
+    }
+}
+
+template <typename ActiveChains>
+void Scheffler_Spaghetti_Stream<ActiveChains>::PerformChainCode() {
+
+    StartStream(img_.cols);
+    for (int r = 0; r < img_.rows; r++) {
+        PushRow(img_.ptr(r));
+    }
+    FinishStream();
+}
 
 
 #undef D0_L
@@ -1077,8 +1512,25 @@ void Scheffler_Spaghetti::PerformChainCode() {
 #undef PIXEL_F
 
 
-REGISTER_CHAINCODEALG(Scheffler)
-REGISTER_CHAINCODEALG(Scheffler_LUT)
-REGISTER_CHAINCODEALG(Scheffler_LUT_PRED)
-REGISTER_CHAINCODEALG(Scheffler_Spaghetti)
-REGISTER_CHAINCODEALG(SchefflerTopology)
+REGISTER_CHAINCODEALG_CHAINS(Scheffler)
+REGISTER_CHAINCODEALG_CHAINS(Scheffler_LUT)
+REGISTER_CHAINCODEALG_CHAINS(Scheffler_LUT_PRED)
+REGISTER_CHAINCODEALG_CHAINS(Scheffler_Packed)
+REGISTER_CHAINCODEALG_CHAINS(Scheffler_Spaghetti)
+REGISTER_CHAINCODEALG_CHAINS(Scheffler_Spaghetti_MT)
+REGISTER_CHAINCODEALG_CHAINS(Scheffler_Spaghetti_Stream)
+REGISTER_CHAINCODEALG_CHAINS(SchefflerTopology)
+REGISTER_CHAINCODEALG_CHAINS(SchefflerTopology_Padded)
+REGISTER_CHAINCODEALG_CHAINS(SchefflerTopology_LUT)
+REGISTER_CHAINCODEALG_CHAINS(SchefflerTopology_LUT_PRED)
+REGISTER_CHAINCODEALG_CHAINS(SchefflerTopology_Spaghetti)
+
+REGISTER_CHAINCODEALG_RETRIEVAL(SchefflerTopology)
+REGISTER_CHAINCODEALG_RETRIEVAL(SchefflerTopology_Padded)
+REGISTER_CHAINCODEALG_RETRIEVAL(SchefflerTopology_LUT)
+REGISTER_CHAINCODEALG_RETRIEVAL(SchefflerTopology_LUT_PRED)
+REGISTER_CHAINCODEALG_RETRIEVAL(SchefflerTopology_Spaghetti)
+
+REGISTER_CHAINCODEALG_LAZY(Scheffler_Spaghetti)
+
+REGISTER_CHAINCODEALG_CHAINCODE(Scheffler_Spaghetti)
@@ -16,7 +16,7 @@ using namespace cv;
 void Suzuki::PerformChainCode() {
     vector<vector<Point>> cv_contours;
     findContours(img_, cv_contours, RETR_LIST, CHAIN_APPROX_NONE);
-    chain_code_ = ChainCode(cv_contours, true);
+    StoreContours(cv_contours, true);
 }
 
 vector<vector<Point>> Suzuki::FindContours() {
@@ -25,7 +25,7 @@ vector<vector<Point>> Suzuki::FindContours() {
     return cv_contours;
 }
 void Suzuki::ConvertToChainCode(const std::vector<std::vector<cv::Point>>& cv_contours) {
-    chain_code_ = ChainCode(cv_contours, true);
+    StoreContours(cv_contours, true);
 }
 
 void Suzuki::PerformChainCodeWithSteps() {
@@ -47,7 +47,7 @@ void SuzukiTopology::PerformChainCode() {
 
     vector<vector<Point>> cv_contours;
     findContours(img_, cv_contours, hierarchy_, RETR_TREE, CHAIN_APPROX_NONE);
-    chain_code_ = ChainCode(cv_contours, true);
+    StoreContours(cv_contours, true);
 }
 
 vector<vector<Point>> SuzukiTopology::FindContours() {
@@ -56,7 +56,7 @@ vector<vector<Point>> SuzukiTopology::FindContours() {
     return cv_contours;
 }
 void SuzukiTopology::ConvertToChainCode(const std::vector<std::vector<cv::Point>>& cv_contours) {
-    chain_code_ = ChainCode(cv_contours, true);
+    StoreContours(cv_contours, true);
 }
 
 // To be fixed
@@ -73,5 +73,78 @@ void SuzukiTopology::PerformChainCodeWithSteps() {
 }
 
 
+void SuzukiExternal::PerformChainCode() {
+    with_hierarchy_ = true;
+    SuzukiExternal::ConvertToChainCode(SuzukiExternal::FindContours());
+}
+
+vector<vector<Point>> SuzukiExternal::FindContours() {
+    vector<vector<Point>> cv_contours;
+    findContours(img_, cv_contours, hierarchy_, RETR_EXTERNAL, CHAIN_APPROX_NONE);
+    return cv_contours;
+}
+void SuzukiExternal::ConvertToChainCode(const std::vector<std::vector<cv::Point>>& cv_contours) {
+    StoreContours(cv_contours, true);
+}
+
+void SuzukiExternal::PerformChainCodeWithSteps() {
+    with_hierarchy_ = true;
+
+    perf_.start();
+    vector<vector<Point>> cv_contours = SuzukiExternal::FindContours();
+    perf_.stop();
+    perf_.store(Step(StepType::ALGORITHM), perf_.last());
+
+    perf_.start();
+    SuzukiExternal::ConvertToChainCode(cv_contours);
+    perf_.stop();
+    perf_.store(Step(StepType::CONVERSION), perf_.last());
+}
+
+
+
+// Holes are the contours with a parent in the two-level hierarchy of RETR_CCOMP. They
+// are listed as siblings, with neither parent nor children.
+vector<vector<Point>> SuzukiHoles::FindContours() {
+    vector<vector<Point>> cv_contours;
+    vector<Vec4i> ccomp_hierarchy;
+    findContours(img_, cv_contours, ccomp_hierarchy, RETR_CCOMP, CHAIN_APPROX_NONE);
+
+    vector<vector<Point>> holes;
+    for (size_t i = 0; i < cv_contours.size(); ++i) {
+        if (ccomp_hierarchy[i][3] != -1) {
+            holes.push_back(std::move(cv_contours[i]));
+        }
+    }
+
+    SiblingsHierarchy(hierarchy_, holes.size());
+    return holes;
+}
+void SuzukiHoles::ConvertToChainCode(const std::vector<std::vector<cv::Point>>& cv_contours) {
+    StoreContours(cv_contours, true);
+}
+
+void SuzukiHoles::PerformChainCode() {
+    with_hierarchy_ = true;
+    SuzukiHoles::ConvertToChainCode(SuzukiHoles::FindContours());
+}
+
+void SuzukiHoles::PerformChainCodeWithSteps() {
+    with_hierarchy_ = true;
+
+    perf_.start();
+    vector<vector<Point>> cv_contours = SuzukiHoles::FindContours();
+    perf_.stop();
+    perf_.store(Step(StepType::ALGORITHM), perf_.last());
+
+    perf_.start();
+    SuzukiHoles::ConvertToChainCode(cv_contours);
+    perf_.stop();
+    perf_.store(Step(StepType::CONVERSION), perf_.last());
+}
+
+
 REGISTER_CHAINCODEALG(Suzuki)
 REGISTER_CHAINCODEALG(SuzukiTopology)
+REGISTER_CHAINCODEALG(SuzukiExternal)
+REGISTER_CHAINCODEALG(SuzukiHoles)
@@ -250,7 +250,7 @@ void SuzukiHandmadeTopology::PerformChainCode() {
 
     vector<vector<Point>> cv_contours;
     myFindContours(img_, cv_contours, hierarchy_);
-    chain_code_ = ChainCode(cv_contours, true);
+    StoreContours(cv_contours, true);
 }
 
 
@@ -21,6 +21,10 @@ ConfigData::ConfigData(const FileStorage& fs) {
     perform_average = ReadBool(fs["perform"]["average"]);
     perform_average_ws = ReadBool(fs["perform"]["average_with_steps"]);
     perform_memory = ReadBool(fs["perform"]["memory"]);
+    perform_scalability = ReadBool(fs["perform"]["scalability"]);
+    perform_throughput = ReadBool(fs["perform"]["throughput"]);
+    perform_open_chains = ReadBool(fs["perform"]["open_chains"]);
+    perform_allocations = ReadBool(fs["perform"]["allocations"]);
 
     perform_check_std = ReadBool(fs["correctness_tests"]["standard"]);
     perform_check_ws = ReadBool(fs["correctness_tests"]["steps"]);
@@ -33,6 +37,9 @@ ConfigData::ConfigData(const FileStorage& fs) {
 
     average_tests_number = static_cast<int>(fs["tests_number"]["average"]);
     average_ws_tests_number = static_cast<int>(fs["tests_number"]["average_with_steps"]);
+    scalability_tests_number = static_cast<int>(fs["tests_number"]["scalability"]);
+    throughput_tests_number = static_cast<int>(fs["tests_number"]["throughput"]);
+    open_chains_tests_number = static_cast<int>(fs["tests_number"]["open_chains"]);
 
     input_txt = "files.txt";
     gnuplot_script_extension = ".gnuplot";
@@ -48,10 +55,15 @@ ConfigData::ConfigData(const FileStorage& fs) {
     latex_charts = "averageCharts.tex";
     latex_memory_file = "memoryAccesses.tex";
     memory_file = "memory_accesses.txt";
+    allocations_file = "allocations.txt";
 
     average_folder = "average_tests";
     average_ws_folder = "average_tests_with_steps";
     memory_folder = "memory_tests";
+    scalability_folder = "scalability_tests";
+    throughput_folder = "throughput_tests";
+    open_chains_folder = "open_chains_tests";
+    allocations_folder = "allocations_tests";
 
     output_path = path(fs["paths"]["output"]) / path(GetDatetimeWithoutSpecialChars());
     input_path = path(fs["paths"]["input"]);
@@ -61,6 +73,11 @@ ConfigData::ConfigData(const FileStorage& fs) {
     read(fs["average_datasets"], average_datasets);
     read(fs["average_datasets_with_steps"], average_ws_datasets);
     read(fs["memory_datasets"], memory_datasets);
+    read(fs["scalability_datasets"], scalability_datasets);
+    read(fs["scalability_threads"], scalability_threads);
+    read(fs["throughput_datasets"], throughput_datasets);
+    read(fs["throughput_threads"], throughput_threads);
+    read(fs["allocations_datasets"], allocations_datasets);
 
     ReadAlgorithms(fs);
 
@@ -0,0 +1,94 @@
+// Copyright (c) 2020, the BACCA contributors, as
+// shown by the AUTHORS file. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+
+#include "find_contours_fast.h"
+
+#include <memory>
+
+#include "register.h"
+
+using namespace std;
+using namespace cv;
+
+// Engine used for mode, made the first time the calling thread needs it
+static ChainCodeAlg& Engine(int mode) {
+    thread_local unique_ptr<ChainCodeAlg> list, tree;
+
+    unique_ptr<ChainCodeAlg>& engine = (mode == RETR_LIST) ? list : tree;
+    if (!engine) {
+        engine = ChainCodeAlgMapSingleton::NewChainCodeAlg(mode == RETR_LIST ? "Scheffler_Spaghetti" : "Cederberg_Topology_Spaghetti");
+        engine->SetPointsOutput(true);
+    }
+    return *engine;
+}
+
+void FindContoursFast(const Mat& image, vector<vector<Point>>& contours, vector<Vec4i>& hierarchy, int mode, int method, Point offset) {
+
+    const bool supported = !image.empty() && image.type() == CV_8UC1 && method == CHAIN_APPROX_NONE &&
+        (mode == RETR_LIST || mode == RETR_TREE);
+    if (!supported) {
+        findContours(image, contours, hierarchy, mode, method, offset);
+        return;
+    }
+
+    // The vectors of the previous contours are handed to the engine, which resizes them
+    ChainCodeAlg& engine = Engine(mode);
+    engine.img_ = image;
+    engine.contours_.swap(contours);
+    engine.PerformChainCode();
+    contours.swap(engine.contours_);
+    engine.img_.release();
+
+    if (mode == RETR_LIST) {
+        SiblingsHierarchy(hierarchy, contours.size());
+    }
+    else {
+        hierarchy.swap(engine.hierarchy_);
+    }
+
+    if (offset != Point()) {
+        for (vector<Point>& contour : contours) {
+            for (Point& p : contour) {
+                p += offset;
+            }
+        }
+    }
+}
+
+void FindContoursFast(const Mat& image, vector<vector<Point>>& contours, int mode, int method, Point offset) {
+    vector<Vec4i> hierarchy;
+    FindContoursFast(image, contours, hierarchy, mode, method, offset);
+}
+
+void FastContours::FindContours() {
+    with_hierarchy_ = (mode_ != RETR_LIST);
+    FindContoursFast(img_, contours_, hierarchy_, mode_, CHAIN_APPROX_NONE);
+}
+
+void FastContours::ConvertToChainCode() {
+    StoreContours(contours_, true);
+}
+
+void FastContours::PerformChainCode() {
+    FindContours();
+    ConvertToChainCode();
+}
+
+void FastContours::PerformChainCodeWithSteps() {
+    perf_.start();
+    FindContours();
+    perf_.stop();
+    perf_.store(Step(StepType::ALGORITHM), perf_.last());
+
+    perf_.start();
+    ConvertToChainCode();
+    perf_.stop();
+    perf_.store(Step(StepType::CONVERSION), perf_.last());
+}
+
+REGISTER_CHAINCODEALG(FastContours)
+REGISTER_CHAINCODEALG(FastContoursTopology)
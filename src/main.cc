@@ -21,6 +21,7 @@
 #include "file_manager.h"
 #include "chaincode_algorithms.h"
 #include "memory_tester.h"
+#include "parallel.h"
 #include "performance_evaluator.h"
 #include "progress_bar.h"
 #include "stream_demultiplexer.h"
@@ -114,12 +115,13 @@ int main()
     }
 
     // Check if labeling methods of the specified algorithms exist
-    ChainCodeAlg::img_ = Mat1b(1, 1, static_cast<uchar>(0));
+    const Mat1b probe_img(1, 1, static_cast<uchar>(0));
     for (size_t i = 0; i < cfg.thin_existing_algorithms.size(); ++i) {
         auto& algo_struct = cfg.thin_existing_algorithms[i];
         string algo_name = algo_struct.test_name;
         const auto& algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(algo_name);
-        if (cfg.perform_average || (cfg.perform_correctness && cfg.perform_check_std)) {
+        algorithm->img_ = probe_img;
+        if (cfg.perform_average || cfg.perform_open_chains || cfg.perform_allocations || cfg.perform_throughput || (cfg.perform_correctness && cfg.perform_check_std)) {
             try {
                 algorithm->PerformChainCode();
                 cfg.thin_average_algorithms.push_back(algo_struct);
@@ -127,6 +129,7 @@ int main()
                 if (cfg.perform_correctness && cfg.perform_check_std) {
                     string check_algo_name = algo_struct.check_name;
                     const auto& check_algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(check_algo_name);
+                    check_algorithm->img_ = probe_img;
                     try {
                         check_algorithm->PerformChainCode();
                         // The check name has already been pushed. If it doesn't work properly standard correctness test is disabled (see catch below)
@@ -150,6 +153,7 @@ int main()
                 if (cfg.perform_correctness && cfg.perform_check_ws) {
                     string check_algo_name = algo_struct.check_name;
                     const auto& check_algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(check_algo_name);
+                    check_algorithm->img_ = probe_img;
                     try {
                         check_algorithm->PerformChainCodeWithSteps();
                         // The check name has already been pushed. If it doesn't work properly steps correctness test is disabled (see catch below)
@@ -174,6 +178,7 @@ int main()
                 if (cfg.perform_correctness && cfg.perform_check_mem) {
                     string check_algo_name = algo_struct.check_name;
                     const auto& check_algorithm = ChainCodeAlgMapSingleton::GetChainCodeAlg(check_algo_name);
+                    check_algorithm->img_ = probe_img;
                     try {
                         check_algorithm->PerformChainCodeMem(temp);
                         // The check name has already been pushed. If it doesn't work properly memory correctness test is disabled (see catch below)
@@ -189,11 +194,24 @@ int main()
                 ob_setconf.Cwarning(algo_name + ": " + e.what());
             }
         }
+        if (cfg.perform_scalability) {
+            try {
+                algorithm->SetThreadsNumber(DefaultThreadsNumber());
+                algorithm->PerformChainCode();
+                cfg.thin_scalability_algorithms.push_back(algo_struct);
+            }
+            catch (const runtime_error& e) {
+                ob_setconf.Cwarning(algo_name + ": " + e.what());
+            }
+        }
     }
 
-    if ((cfg.perform_average || (cfg.perform_correctness && cfg.perform_check_std)) && cfg.thin_average_algorithms.size() == 0) {
+    if ((cfg.perform_average || cfg.perform_open_chains || cfg.perform_allocations || cfg.perform_throughput || (cfg.perform_correctness && cfg.perform_check_std)) && cfg.thin_average_algorithms.size() == 0) {
         ob_setconf.Cwarning("There are no 'algorithms' with valid 'PerformChainCode()' method, related tests will be skipped");
         cfg.perform_average = false;
+        cfg.perform_open_chains = false;
+        cfg.perform_allocations = false;
+        cfg.perform_throughput = false;
         cfg.perform_check_std = false;
     }
 
@@ -209,6 +227,11 @@ int main()
         cfg.perform_check_mem = false;
     }
 
+    if (cfg.perform_scalability && cfg.thin_scalability_algorithms.size() == 0) {
+        ob_setconf.Cwarning("There are no 'algorithms' with valid 'SetThreadsNumber(...)' method, related tests will be skipped");
+        cfg.perform_scalability = false;
+    }
+
     if (cfg.perform_average && (cfg.average_tests_number < 1 || cfg.average_tests_number > 999)) {
         ob_setconf.Cwarning("'average test' repetitions cannot be less than 1 or more than 999, skipped");
         cfg.perform_average = false;
@@ -219,6 +242,33 @@ int main()
         cfg.perform_average_ws = false;
     }
 
+    if (cfg.perform_open_chains && (cfg.open_chains_tests_number < 1 || cfg.open_chains_tests_number > 999)) {
+        ob_setconf.Cwarning("'open chains test' repetitions cannot be less than 1 or more than 999, skipped");
+        cfg.perform_open_chains = false;
+    }
+
+    if (cfg.perform_scalability && (cfg.scalability_tests_number < 1 || cfg.scalability_tests_number > 999)) {
+        ob_setconf.Cwarning("'scalability test' repetitions cannot be less than 1 or more than 999, skipped");
+        cfg.perform_scalability = false;
+    }
+
+    if (cfg.perform_scalability && (cfg.scalability_threads.size() == 0 ||
+        *min_element(cfg.scalability_threads.begin(), cfg.scalability_threads.end()) < 1)) {
+        ob_setconf.Cwarning("'scalability_threads' must be a non empty list of positive numbers, 'scalability test' skipped");
+        cfg.perform_scalability = false;
+    }
+
+    if (cfg.perform_throughput && (cfg.throughput_tests_number < 1 || cfg.throughput_tests_number > 999)) {
+        ob_setconf.Cwarning("'throughput test' repetitions cannot be less than 1 or more than 999, skipped");
+        cfg.perform_throughput = false;
+    }
+
+    if (cfg.perform_throughput && (cfg.throughput_threads.size() == 0 ||
+        *min_element(cfg.throughput_threads.begin(), cfg.throughput_threads.end()) < 1)) {
+        ob_setconf.Cwarning("'throughput_threads' must be a non empty list of positive numbers, 'throughput test' skipped");
+        cfg.perform_throughput = false;
+    }
+
     if ((cfg.perform_correctness) && cfg.check_datasets.size() == 0) {
         ob_setconf.Cwarning("There are no datasets specified for 'correctness test', skipped");
         cfg.perform_correctness = false;
@@ -239,8 +289,31 @@ int main()
         cfg.perform_memory = false;
     }
 
+    if ((cfg.perform_scalability) && cfg.scalability_datasets.size() == 0) {
+        ob_setconf.Cwarning("There are no datasets specified for 'scalability test', skipped");
+        cfg.perform_scalability = false;
+    }
+
+    if ((cfg.perform_throughput) && cfg.throughput_datasets.size() == 0) {
+        ob_setconf.Cwarning("There are no datasets specified for 'throughput test', skipped");
+        cfg.perform_throughput = false;
+    }
+
+    if ((cfg.perform_allocations) && cfg.allocations_datasets.size() == 0) {
+        ob_setconf.Cwarning("There are no datasets specified for 'allocations test', skipped");
+        cfg.perform_allocations = false;
+    }
+
+#ifndef BACCA_COUNT_ALLOCATIONS
+    if (cfg.perform_allocations) {
+        ob_setconf.Cwarning("Heap allocations are only counted when built with BACCA_COUNT_ALLOCATIONS, 'allocations test' skipped");
+        cfg.perform_allocations = false;
+    }
+#endif
+
     if (!cfg.perform_average && !cfg.perform_correctness &&
-        !cfg.perform_memory && !cfg.perform_average_ws) {
+        !cfg.perform_memory && !cfg.perform_average_ws && !cfg.perform_scalability &&
+        !cfg.perform_throughput && !cfg.perform_open_chains && !cfg.perform_allocations) {
         ob_setconf.Cerror("There are no tests to perform");
     }
 
@@ -276,6 +349,15 @@ int main()
         if (cfg.perform_average_ws) {
             ds.insert(ds.end(), cfg.average_ws_datasets.begin(), cfg.average_ws_datasets.end());
         }
+        if (cfg.perform_scalability) {
+            ds.insert(ds.end(), cfg.scalability_datasets.begin(), cfg.scalability_datasets.end());
+        }
+        if (cfg.perform_throughput) {
+            ds.insert(ds.end(), cfg.throughput_datasets.begin(), cfg.throughput_datasets.end());
+        }
+        if (cfg.perform_allocations) {
+            ds.insert(ds.end(), cfg.allocations_datasets.begin(), cfg.allocations_datasets.end());
+        }
         std::sort(ds.begin(), ds.end());
         ds.erase(unique(ds.begin(), ds.end()), ds.end());
         CheckDatasetExistence(ds, true); // To check single dataset
@@ -307,9 +389,31 @@ int main()
                 cfg.perform_memory = false;
             }
         }
+
+        if (cfg.perform_scalability) {
+            if (!CheckDatasetExistence(cfg.scalability_datasets, false)) {
+                ob_setconf.Cwarning("There are no valid datasets for 'scalability test', skipped");
+                cfg.perform_scalability = false;
+            }
+        }
+
+        if (cfg.perform_throughput) {
+            if (!CheckDatasetExistence(cfg.throughput_datasets, false)) {
+                ob_setconf.Cwarning("There are no valid datasets for 'throughput test', skipped");
+                cfg.perform_throughput = false;
+            }
+        }
+
+        if (cfg.perform_allocations) {
+            if (!CheckDatasetExistence(cfg.allocations_datasets, false)) {
+                ob_setconf.Cwarning("There are no valid datasets for 'allocations test', skipped");
+                cfg.perform_allocations = false;
+            }
+        }
     }
 
-    if (cfg.perform_average || cfg.perform_average_ws || cfg.perform_memory) {
+    if (cfg.perform_average || cfg.perform_average_ws || cfg.perform_memory || cfg.perform_scalability ||
+        cfg.perform_throughput || cfg.perform_open_chains || cfg.perform_allocations) {
         // Set and create current output directory
         if (!create_directories(cfg.output_path, ec)) {
             ob_setconf.Cerror("Unable to create output directory '" + cfg.output_path.string() + "' - " + ec.message());
@@ -356,6 +460,26 @@ int main()
         yt.MemoryTest();
     }
 
+    // Scalability test
+    if (cfg.perform_scalability) {
+        yt.ScalabilityTest();
+    }
+
+    // Throughput test
+    if (cfg.perform_throughput) {
+        yt.ThroughputTest();
+    }
+
+    // Open chains test
+    if (cfg.perform_open_chains) {
+        yt.OpenChainsTest();
+    }
+
+    // Allocations test
+    if (cfg.perform_allocations) {
+        yt.AllocationsTest();
+    }
+
     // Latex Generator
     if (cfg.perform_average || cfg.perform_average_ws || cfg.perform_memory) {
         yt.LatexGenerator();